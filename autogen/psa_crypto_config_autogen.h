@@ -6,6 +6,8 @@
 #define PSA_WANT_KEY_TYPE_AES
 #define PSA_WANT_ALG_CCM
 #define PSA_WANT_ALG_ECB_NO_PADDING
+#define PSA_WANT_ALG_CBC_NO_PADDING
+#define PSA_WANT_ALG_CMAC
 #define MBEDTLS_PSA_CRYPTO_EXTERNAL_RNG
 #define MBEDTLS_PSA_ACCEL_ALG_SHA_1
 #define MBEDTLS_PSA_ACCEL_ALG_SHA_224
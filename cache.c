@@ -0,0 +1,151 @@
+/*
+ * cache.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "cache.h"
+
+#include "rfid_config.h"
+
+#define CACHE_TTL_MS              ((uint32_t)RFID_CACHE_TTL * MILLISECOND_TICKS_PER_SECOND)
+
+/* Cached payloads; same layout as the CONTENT_CACHE token */
+static tokTypeContentCache cache[CACHE_ENTRIES];
+static uint32_t storedAt[CACHE_ENTRIES];
+
+static uint32_t hits = 0;
+static uint32_t misses = 0;
+static uint32_t expired = 0;
+static uint32_t writes = 0;
+
+/** @brief Load persisted payloads
+ *  @note Persisted entries get a new TTL from boot; the tick is not kept
+ */
+void cacheInit(void)
+{
+  uint32_t now = halCommonGetInt32uMillisecondTick();
+
+  memset(cache, 0, sizeof(cache));
+
+  for (uint8_t i = 0; i < CACHE_ENTRIES; i++) {
+#if RFID_CACHE_PERSIST
+    halCommonGetIndexedToken(&cache[i], TOKEN_CONTENT_CACHE, i);
+#endif
+    storedAt[i] = now;
+  }
+}
+
+/** @brief Find the entry of a UID and source
+ *  @return Index, or CACHE_ENTRIES if not cached
+ */
+static uint8_t findEntry(const rfid_tag_t *rfid_tag, const uint16_t source)
+{
+  uint8_t i;
+
+  for (i = 0; i < CACHE_ENTRIES; i++) {
+    if ((cache[i].size == rfid_tag->size)
+        && (cache[i].protocol == rfid_tag->protocol)
+        && (cache[i].source == source)
+        && (memcmp(cache[i].uid, rfid_tag->rfid, rfid_tag->size) == 0))
+      break;
+  }
+
+  return i;
+}
+
+/** @brief Get the cached payload of a tag
+ *  @param rfid_tag Selected tag
+ *  @param source What was read (CACHE_SOURCE); a sector or file that is
+ *         no longer the configured one does not match
+ *  @param payload Buffer for the payload
+ *  @param len Size of buffer
+ *  @return Length of payload, or -1 if not cached or older than RFID_CACHE_TTL
+ */
+int16_t cacheLookup(const rfid_tag_t *rfid_tag, const uint16_t source, uint8_t *payload, const uint16_t len)
+{
+  if (RFID_CACHE_TTL == 0)
+    return -1;
+
+  uint8_t i = findEntry(rfid_tag, source);
+
+  if (i == CACHE_ENTRIES) {
+    misses++;
+    return -1;
+  }
+
+  if ((halCommonGetInt32uMillisecondTick() - storedAt[i] >= CACHE_TTL_MS) || (cache[i].length > len)) {
+    expired++;
+    misses++;
+    return -1;
+  }
+
+  hits++;
+  memcpy(payload, cache[i].payload, cache[i].length);
+  return cache[i].length;
+}
+
+/** @brief Cache the payload read from a tag
+ *  @param rfid_tag Tag
+ *  @param source What was read (CACHE_SOURCE)
+ *  @param payload Payload
+ *  @param len Length of payload; larger than CACHE_PAYLOAD_MAX is not cached
+ *  @note Replaces the entry of the UID and source, or else the oldest entry
+ */
+void cacheStore(const rfid_tag_t *rfid_tag, const uint16_t source, const uint8_t *payload, const uint16_t len)
+{
+  uint32_t now = halCommonGetInt32uMillisecondTick();
+  uint8_t i = findEntry(rfid_tag, source);
+
+  if ((RFID_CACHE_TTL == 0) || (len > CACHE_PAYLOAD_MAX))
+    return;
+
+  if (i == CACHE_ENTRIES) {
+    i = 0;
+    for (uint8_t j = 1; j < CACHE_ENTRIES; j++) {
+      if ((cache[i].size != 0) && ((cache[j].size == 0) || (now - storedAt[j] > now - storedAt[i])))
+        i = j;
+    }
+  }
+  else if ((cache[i].length == len) && (memcmp(cache[i].payload, payload, len) == 0)) {
+    // Unchanged; only restart the TTL
+    storedAt[i] = now;
+    return;
+  }
+
+  cache[i].size = rfid_tag->size;
+  cache[i].protocol = rfid_tag->protocol;
+  cache[i].source = source;
+  memcpy(cache[i].uid, rfid_tag->rfid, rfid_tag->size);
+  cache[i].length = (uint8_t)len;
+  memcpy(cache[i].payload, payload, len);
+  storedAt[i] = now;
+
+#if RFID_CACHE_PERSIST
+  halCommonSetIndexedToken(TOKEN_CONTENT_CACHE, i, &cache[i]);
+  writes++;
+#endif
+}
+
+/** @brief Drop all cached payloads (also from NVM3)
+ */
+void cacheClear(void)
+{
+  memset(cache, 0, sizeof(cache));
+
+#if RFID_CACHE_PERSIST
+  for (uint8_t i = 0; i < CACHE_ENTRIES; i++)
+    halCommonSetIndexedToken(TOKEN_CONTENT_CACHE, i, &cache[i]);
+#endif
+}
+
+/** @brief Print hit/miss counters
+ */
+void cachePrintStats(void)
+{
+  uint32_t lookups = hits + misses;
+
+  emberAfCorePrintln("cache: ttl %d s, %d lookups, %d hits (%d%%), %d misses (%d expired), %d nvm3 writes",
+                     RFID_CACHE_TTL, lookups, hits, lookups ? (hits * 100) / lookups : 0, misses, expired, writes);
+}
@@ -0,0 +1,27 @@
+/*
+ * cache.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef CACHE_H_
+#define CACHE_H_
+
+#include "app/framework/include/af.h"
+
+#include "rfid.h"
+
+#define CACHE_ENTRIES             CONTENT_CACHE_ELEMENTS
+#define CACHE_PAYLOAD_MAX         CONTENT_CACHE_PAYLOAD_MAX
+
+/*! Part of the key naming what was read: tag family and sector or file */
+#define CACHE_SOURCE(family, index)   ((uint16_t)(((family) << 8) | (index)))
+
+void cacheInit(void);
+int16_t cacheLookup(const rfid_tag_t *rfid_tag, uint16_t source, uint8_t *payload, uint16_t len);
+void cacheStore(const rfid_tag_t *rfid_tag, uint16_t source, const uint8_t *payload, uint16_t len);
+void cacheClear(void);
+void cachePrintStats(void);
+
+#endif /* CACHE_H_ */
@@ -0,0 +1,383 @@
+/***************************************************************************//**
+ * @brief RFID reader configuration header.
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+#ifndef RFID_CONFIG_H
+#define RFID_CONFIG_H
+
+// <h>Protocol polling
+
+// <q RFID_POLL_ISO14443A> Poll ISO14443A
+// <i> Default: TRUE
+#define RFID_POLL_ISO14443A   1
+
+// <q RFID_POLL_ISO14443B> Poll ISO14443B
+// <i> Default: FALSE
+#define RFID_POLL_ISO14443B   0
+
+// <q RFID_POLL_FELICA> Poll FeliCa
+// <i> Default: FALSE
+#define RFID_POLL_FELICA   0
+
+// <q RFID_POLL_ISO15693> Poll ISO15693
+// <i> Default: FALSE
+#define RFID_POLL_ISO15693   0
+
+// <q RFID_POLL_PROBE> Probe with WUPA before a full read
+// <i> Default: TRUE
+// <i> An LPCD wake without an ATQA goes straight back to LPCD
+#define RFID_POLL_PROBE   1
+
+// <o RFID_POLL_PROBE_TIMEOUT> Probe frame wait time (us) <100-5000>
+// <i> Default: 500
+#define RFID_POLL_PROBE_TIMEOUT   500
+
+// </h>
+
+// <h>Power sequencing
+
+// <q RFID_RAIL_LPCD> Keep the 5V rail on while LPCD is armed
+// <i> Default: FALSE
+// <i> Off: the rail (ENABLE_5V) is only on while the field is used for a read
+#define RFID_RAIL_LPCD   0
+
+// <o RFID_RAIL_SETTLE_MS> Wait after switching the 5V rail on (ms) <0-100>
+// <i> Default: 2
+#define RFID_RAIL_SETTLE_MS   2
+
+// </h>
+
+// <h>Low power card detection
+
+// <o RFID_LPCD_EWMA_SHIFT> Baseline smoothing (EWMA weight 1/2^n) <0-6>
+// <i> Default: 3
+// <i> The I/Q result of every wake without a card is averaged into the baseline
+#define RFID_LPCD_EWMA_SHIFT   3
+
+// <o RFID_LPCD_DRIFT_MAX> Baseline drift before the detection window is moved <1-10>
+// <i> Default: 2
+#define RFID_LPCD_DRIFT_MAX   2
+
+// <o RFID_LPCD_CONFIRM_MS> Time without a card answering before a wake counts as false (ms) <0-10000>
+// <i> Default: 1000
+// <i> Wakes of a card that is still approaching are not averaged into the baseline
+#define RFID_LPCD_CONFIRM_MS   1000
+
+// <o RFID_LPCD_THRESHOLD> Initial detection window half-width (ADC counts) <1-16>
+// <i> Default: 3
+#define RFID_LPCD_THRESHOLD   3
+
+// <o RFID_LPCD_THRESHOLD_MIN> Narrowest detection window half-width <1-16>
+// <i> Default: 2
+#define RFID_LPCD_THRESHOLD_MIN   2
+
+// <o RFID_LPCD_THRESHOLD_MAX> Widest detection window half-width <1-16>
+// <i> Default: 8
+// <i> A wider window wakes less on noise but needs the card closer
+#define RFID_LPCD_THRESHOLD_MAX   8
+
+// <o RFID_LPCD_FALSE_WAKE_TARGET> Target false wakes per tuning period <0-100>
+// <i> Default: 4
+// <i> The window is widened above the target and narrowed below half of it.
+// <i> A burst of wakes confirmed together counts once; wakes followed by a
+// <i> card answering within RFID_LPCD_CONFIRM_MS never count
+#define RFID_LPCD_FALSE_WAKE_TARGET   4
+
+// <o RFID_LPCD_TUNE_PERIOD> Threshold tuning period (s) <0-86400>
+// <i> Default: 3600
+// <i> 0 keeps the threshold fixed. Needs RFID_LPCD_CONFIRM_MS > 0, else
+// <i> approaching cards count as false wakes and widen the window
+#define RFID_LPCD_TUNE_PERIOD   3600
+
+// <o RFID_LPCD_PERIOD_MIN> Fastest LPCD power-down period (ms) <5-1000>
+// <i> Default: 10
+// <i> Used after a read and during busy hours
+#define RFID_LPCD_PERIOD_MIN   10
+
+// <o RFID_LPCD_PERIOD_MAX> Slowest LPCD power-down period (ms) <5-30000>
+// <i> Default: 320
+// <i> Worst case card detection latency on an idle door
+#define RFID_LPCD_PERIOD_MAX   320
+
+// <o RFID_LPCD_ACTIVE_HOLD> Fast polling after a read (s) <0-86400>
+// <i> Default: 60
+#define RFID_LPCD_ACTIVE_HOLD   60
+
+// <o RFID_LPCD_BACKOFF_STEP> Idle time per doubling of the power-down period (s) <1-86400>
+// <i> Default: 60
+#define RFID_LPCD_BACKOFF_STEP   60
+
+// <o RFID_LPCD_BUSY_START> Busy hours start (hour of day) <0-23>
+// <i> Default: 7
+// <i> Busy hours poll at the fastest period; they need the time of day from "rfid set-clock"
+#define RFID_LPCD_BUSY_START   7
+
+// <o RFID_LPCD_BUSY_END> Busy hours end (hour of day) <0-23>
+// <i> Default: 18
+// <i> Same as the start disables busy hours
+#define RFID_LPCD_BUSY_END   18
+
+// </h>
+
+// <h>Presence tracking
+
+// <o RFID_PRESENCE_INTERVAL> Interval between presence probes (ms) <0-10000>
+// <i> Default: 500
+// <i> After a read the tag is probed with WUPA and a cascade level 1
+// <i> anticollision (ATQA and UID matched) until it leaves;
+// <i> 0 disables tracking (LPCD is re-armed right after each read)
+#define RFID_PRESENCE_INTERVAL   500
+
+// <o RFID_PRESENCE_MISSES> Missed probes before a tag is reported as gone <1-10>
+// <i> Default: 2
+#define RFID_PRESENCE_MISSES   2
+
+// </h>
+
+// <h>Energy accounting
+
+// <o RFID_ENERGY_EM0_UA> MCU current in EM0 (uA) <0-100000>
+// <i> Default: 3000
+#define RFID_ENERGY_EM0_UA   3000
+
+// <o RFID_ENERGY_EM1_UA> MCU current in EM1 (uA) <0-100000>
+// <i> Default: 1200
+#define RFID_ENERGY_EM1_UA   1200
+
+// <o RFID_ENERGY_EM2_UA> MCU current in EM2 and EM3 (uA) <0-1000>
+// <i> Default: 6
+#define RFID_ENERGY_EM2_UA   6
+
+// <o RFID_ENERGY_READER_STANDBY_UA> Reader current between LPCD detections (uA) <0-1000>
+// <i> Default: 3
+#define RFID_ENERGY_READER_STANDBY_UA   3
+
+// <o RFID_ENERGY_LPCD_DETECT_NC> Reader charge per LPCD detection (nC) <0-100000>
+// <i> Default: 2000
+#define RFID_ENERGY_LPCD_DETECT_NC   2000
+
+// <o RFID_ENERGY_READER_ACTIVE_UA> Reader current while arming LPCD, field off (uA) <0-100000>
+// <i> Default: 8000
+#define RFID_ENERGY_READER_ACTIVE_UA   8000
+
+// <o RFID_ENERGY_FIELD_UA> Reader current with the field on (uA) <0-500000>
+// <i> Default: 100000
+#define RFID_ENERGY_FIELD_UA   100000
+
+// <o RFID_ENERGY_TX_UC> Radio charge per report (uC) <0-10000>
+// <i> Default: 100
+#define RFID_ENERGY_TX_UC   100
+
+// <o RFID_ENERGY_POLL_UC> Radio charge per parent poll (uC) <0-10000>
+// <i> Default: 60
+#define RFID_ENERGY_POLL_UC   60
+
+// <o RFID_ENERGY_POLL_INTERVAL> Parent poll interval (s) <1-3600>
+// <i> Default: 300
+// <i> Polls are estimated from uptime, not counted
+// <i> Counted only when built as a sleepy end device
+#define RFID_ENERGY_POLL_INTERVAL   300
+
+// <o RFID_ENERGY_REPORT_INTERVAL> Interval between energy reports (h) <0-168>
+// <i> Default: 24
+// <i> 0 disables the report
+#define RFID_ENERGY_REPORT_INTERVAL   24
+
+// </h>
+
+// <h>Antenna tuning
+
+// <o RFID_TUNE_READS> Reads of the reference card per setting <1-50>
+// <i> Default: 10
+// <i> A setting passes only if all reads return the reference UID
+#define RFID_TUNE_READS   10
+
+// <o RFID_TUNE_MARGIN_READS> Reads per receiver threshold step when measuring the margin <1-20>
+// <i> Default: 3
+#define RFID_TUNE_MARGIN_READS   3
+
+// <o RFID_TUNE_MIN_MARGIN> Minimum margin (MinLevel steps) for a setting to be used <0-15>
+// <i> Default: 2
+// <i> The lowest transmitter level with this margin is chosen
+#define RFID_TUNE_MIN_MARGIN   2
+
+// </h>
+
+// <h>Duplicate suppression
+
+// <o RFID_DEDUP_WINDOW> Hold-off window per UID (ms) <0-60000>
+// <i> Default: 2000
+// <i> A UID read again within the window is counted but not processed or
+// <i> reported; 0 disables suppression
+#define RFID_DEDUP_WINDOW   2000
+
+// </h>
+
+// <h>Content cache
+
+// <o RFID_CACHE_TTL> Time a cached payload is used instead of reading the tag (s) <0-86400>
+// <i> Default: 3600
+// <i> Applies to the NDEF record and Classic sector reads; 0 disables the cache.
+// <i> On a hit the UID is trusted; a Classic card is not authenticated again.
+#define RFID_CACHE_TTL   3600
+
+// <q RFID_CACHE_PERSIST> Keep cached payloads in NVM3
+// <i> Default: FALSE
+// <i> Entries are only written when the payload changes. After a reset,
+// <i> persisted entries are valid for one TTL.
+#define RFID_CACHE_PERSIST   0
+
+// </h>
+
+// <h>MIFARE Classic
+
+// <q RFID_CLASSIC_READ> Read a sector from MIFARE Classic cards
+// <i> Default: FALSE
+// <i> Only cards that authenticate with the key are reported
+#define RFID_CLASSIC_READ   0
+
+// <o RFID_CLASSIC_SECTOR> Sector to read <0-39>
+// <i> Default: 1
+#define RFID_CLASSIC_SECTOR   1
+
+// <o RFID_CLASSIC_KEY_TYPE> Key type
+// <0x60=> Key A
+// <0x61=> Key B
+// <i> Default: Key A
+#define RFID_CLASSIC_KEY_TYPE   0x60
+
+// <o RFID_CLASSIC_KEY> Key number in the reader EEPROM (see rfid store-key) <0-127>
+// <i> Default: 0
+#define RFID_CLASSIC_KEY   0
+
+// <o RFID_CLASSIC_VALUE_OP> Value block operation on every tap
+// <0=> None
+// <0xC1=> Increment (e.g. visit counter)
+// <0xC0=> Decrement (stored value; refused if the value is too low)
+// <i> Default: None
+// <i> Uses the key type and key number above
+#define RFID_CLASSIC_VALUE_OP   0
+
+// <o RFID_CLASSIC_VALUE_BLOCK> Value block <1-255>
+// <i> Default: 4
+#define RFID_CLASSIC_VALUE_BLOCK   4
+
+// <o RFID_CLASSIC_VALUE_AMOUNT> Amount to add or subtract <1-65535>
+// <i> Default: 1
+#define RFID_CLASSIC_VALUE_AMOUNT   1
+
+// </h>
+
+// <h>DESFire
+
+// <q RFID_DESFIRE_READ> Authenticate (EV2) and read a data file from DESFire cards
+// <i> Default: FALSE
+// <i> Off: DESFire cards go through the ISO-DEP pipeline (SUN check)
+// <i> NTAG 424 DNA (told apart by GET_VERSION) and cards without
+// <i> RFID_DESFIRE_AID always go through the ISO-DEP pipeline
+#define RFID_DESFIRE_READ   0
+
+// <o RFID_DESFIRE_AID> Application ID <0x000001-0xFFFFFF>
+// <i> Default: 0x000001
+#define RFID_DESFIRE_AID   0x000001
+
+// <o RFID_DESFIRE_FILE> Standard data file number <0-31>
+// <i> Default: 0
+#define RFID_DESFIRE_FILE   0
+
+// <o RFID_DESFIRE_LENGTH> Bytes to read from the start of the file <1-192>
+// <i> Default: 32
+#define RFID_DESFIRE_LENGTH   32
+
+// <o RFID_DESFIRE_KEY_NO> Application key number used to authenticate <0-13>
+// <i> Default: 1
+#define RFID_DESFIRE_KEY_NO   1
+
+// <o RFID_DESFIRE_KEY> Key number of the (master) AES key (see rfid store-aes-key) <0-7>
+// <i> Default: 0
+#define RFID_DESFIRE_KEY   0
+
+// <q RFID_DESFIRE_DIVERSIFY> Diversify the key per card (AN10922)
+// <i> Default: TRUE
+#define RFID_DESFIRE_DIVERSIFY   1
+
+// <s RFID_DESFIRE_SYSTEM_IDENTIFIER> System identifier used for key diversification (AN10922)
+// <i> Default: "STROMBERGS"
+#define RFID_DESFIRE_SYSTEM_IDENTIFIER   "STROMBERGS"
+
+// </h>
+
+// <h>NTAG / Ultralight
+
+// <q RFID_NDEF_READ> Read the first NDEF record
+// <i> Default: FALSE
+#define RFID_NDEF_READ   0
+
+// </h>
+
+// <h>Originality signature
+
+// <q RFID_ORIGINALITY_CHECK> Check NTAG/Ultralight EV1 originality signature
+// <i> Default: FALSE
+// <i> Verified UIDs are cached, so repeat taps skip the signature check
+// <i> Needs a Secure Vault High device (secp128r1 in the SE); the build
+// <i> fails with #error on other devices, e.g. EFR32MG21A (Vault Mid)
+#define RFID_ORIGINALITY_CHECK   0
+
+// </h>
+
+// <h>NTAG 424 DNA SUN
+
+// <q RFID_SUN_VERIFY> Verify SUN messages on ISO-DEP tags
+// <i> Default: FALSE
+// <i> Only reads with a valid SUN message and a new read counter are reported
+#define RFID_SUN_VERIFY   0
+
+// <o RFID_SUN_COUNTERS> Number of tags with a stored read counter <1-128>
+// <i> Default: 16
+// <i> Counters are kept for the most recently seen tags only. A tag not seen
+// <i> while this many other tags were has lost its counter, and its old SUN
+// <i> messages are accepted again until it is read once more.
+#define RFID_SUN_COUNTERS   16
+
+// <o RFID_SUN_PERSIST_STEP> Read counter advance between NVM3 writes <1-1024>
+// <i> Default: 8
+// <i> A counter is written when its tag is first stored and then only when it
+// <i> has advanced by this much. After a reboot up to this many - 1 reads per
+// <i> tag may be lost, so the first reads after a reboot are rejected until the
+// <i> counter passes the stored value + this - 1. 1 writes on every read.
+#define RFID_SUN_PERSIST_STEP   8
+
+// <o RFID_SUN_META_KEY> Key number of SDMMetaReadKey (see rfid store-aes-key) <0-7>
+// <i> Default: 1
+#define RFID_SUN_META_KEY   1
+
+// <o RFID_SUN_FILE_KEY> Key number of SDMFileReadKey (see rfid store-aes-key) <0-7>
+// <i> Default: 2
+#define RFID_SUN_FILE_KEY   2
+
+// <s RFID_SUN_PICC_PARAM> URL parameter holding the encrypted PICC data
+// <i> Default: "picc_data="
+#define RFID_SUN_PICC_PARAM   "picc_data="
+
+// <s RFID_SUN_CMAC_PARAM> URL parameter holding the SDM MAC
+// <i> Default: "cmac="
+#define RFID_SUN_CMAC_PARAM   "cmac="
+
+// </h>
+
+// <h>Debug
+
+// <q RFID_DEBUG_IRQ> Print reader IRQ and error registers on every wake
+// <i> Default: FALSE
+// <i> The UART time (several ms at 115200 baud) is spent on every wake,
+// <i> including false wakes
+#define RFID_DEBUG_IRQ   0
+
+// </h>
+
+#endif // RFID_CONFIG_H
+
+// <<< end of configuration section >>>
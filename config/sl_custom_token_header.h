@@ -84,3 +84,104 @@
  * #endif
  *
  ******************************************************************************/
+
+#include "rfid_config.h"
+
+// NTAG 424 DNA SUN read counters (replay check), one element per UID,
+// least recently seen replaced first (at most 128, the key range up to ORIGINALITY_UIDS)
+#define NVM3KEY_SUN_COUNTERS        (NVM3KEY_DOMAIN_USER | 0x5300)
+#define CREATOR_SUN_COUNTERS        0x5300
+#define SUN_COUNTERS_ELEMENTS       RFID_SUN_COUNTERS
+#define SUN_COUNTERS_DEFAULT        { { 0 }, 0, 0 }
+
+// UIDs with a verified originality signature (only with RFID_ORIGINALITY_CHECK)
+#define NVM3KEY_ORIGINALITY_UIDS    (NVM3KEY_DOMAIN_USER | 0x5380)
+#define CREATOR_ORIGINALITY_UIDS    0x5380
+#define ORIGINALITY_UIDS_ELEMENTS   16
+#define ORIGINALITY_UIDS_DEFAULT    { 0, { 0 } }
+
+// Tag payloads (NDEF record or Classic sector) keyed by UID
+#define NVM3KEY_CONTENT_CACHE       (NVM3KEY_DOMAIN_USER | 0x5400)
+#define CREATOR_CONTENT_CACHE       0x5400
+#define CONTENT_CACHE_ELEMENTS      8
+#define CONTENT_CACHE_PAYLOAD_MAX   64
+#define CONTENT_CACHE_DEFAULT       { 0, 0, 0, { 0 }, 0, { 0 } }
+
+// LPCD detection window and I/Q baseline
+#define NVM3KEY_LPCD_CALIBRATION    (NVM3KEY_DOMAIN_USER | 0x5500)
+#define CREATOR_LPCD_CALIBRATION    0x5500
+#define LPCD_CALIBRATION_MAGIC      0xA5
+#define LPCD_CALIBRATION_DEFAULT    { 0, 0, 0, 0, 0, 0, 0, 0, 0 }
+
+// Antenna and receiver profile found by the tuning sweep
+#define NVM3KEY_RFID_TUNING         (NVM3KEY_DOMAIN_USER | 0x5600)
+#define CREATOR_RFID_TUNING         0x5600
+#define RFID_TUNING_MAGIC           0x5A
+#define RFID_TUNING_DEFAULT         { 0, 0, 0, 0, 0, 0, 0 }
+
+#ifdef DEFINETYPES
+typedef struct {
+  uint8_t uid[7];
+  uint32_t counter;                   // Last SDMReadCtr accepted
+  uint32_t seen;                      // Tap sequence number of the last accepted read; 0 = free
+} tokTypeSunCounter;
+
+typedef struct {
+  uint8_t size;
+  uint8_t uid[7];
+} tokTypeOriginalityUid;
+
+typedef struct {
+  uint8_t size;                       // 0 = free
+  uint8_t protocol;
+  uint16_t source;                    // What was read, see CACHE_SOURCE
+  uint8_t uid[10];
+  uint8_t length;
+  uint8_t payload[CONTENT_CACHE_PAYLOAD_MAX];
+} tokTypeContentCache;
+
+typedef struct {
+  uint8_t magic;                      // LPCD_CALIBRATION_MAGIC if valid
+  uint8_t qMin;                       // LPCD_QMIN register
+  uint8_t qMax;                       // LPCD_QMAX register
+  uint8_t iMin;                       // LPCD_IMIN register
+  uint8_t windowI;                    // Window centre
+  uint8_t windowQ;
+  uint8_t threshold;                  // Window half-width
+  uint16_t baselineI;                 // Q8.8 EWMA
+  uint16_t baselineQ;
+} tokTypeLpcdCalibration;
+
+typedef struct {
+  uint8_t magic;                      // RFID_TUNING_MAGIC if valid
+  uint8_t txAmp;                      // TX_AMP register
+  uint8_t drvCon;                     // DRV_CON register
+  uint8_t rxThreshold;                // RX_THRESHOLD register
+  uint8_t rxAna;                      // RX_ANA register
+  uint8_t level;                      // Transmitter level (0 = lowest power)
+  uint8_t margin;                     // MinLevel steps above the stored threshold that still read
+} tokTypeRfidTuning;
+#endif
+
+#ifdef DEFINETOKENS
+DEFINE_INDEXED_TOKEN(SUN_COUNTERS,
+                     tokTypeSunCounter,
+                     SUN_COUNTERS_ELEMENTS,
+                     SUN_COUNTERS_DEFAULT)
+#if RFID_ORIGINALITY_CHECK
+DEFINE_INDEXED_TOKEN(ORIGINALITY_UIDS,
+                     tokTypeOriginalityUid,
+                     ORIGINALITY_UIDS_ELEMENTS,
+                     ORIGINALITY_UIDS_DEFAULT)
+#endif
+DEFINE_INDEXED_TOKEN(CONTENT_CACHE,
+                     tokTypeContentCache,
+                     CONTENT_CACHE_ELEMENTS,
+                     CONTENT_CACHE_DEFAULT)
+DEFINE_BASIC_TOKEN(LPCD_CALIBRATION,
+                   tokTypeLpcdCalibration,
+                   LPCD_CALIBRATION_DEFAULT)
+DEFINE_BASIC_TOKEN(RFID_TUNING,
+                   tokTypeRfidTuning,
+                   RFID_TUNING_DEFAULT)
+#endif
@@ -0,0 +1,109 @@
+/*
+ * dedup.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "dedup.h"
+
+#include "rfid_config.h"
+
+typedef struct {
+  uint8_t size;                               /**< 0 = free */
+  uint8_t protocol;
+  uint8_t rfid[10];
+  uint32_t lastSeen;                          /**< ms tick of the last read */
+  uint16_t repeats;                           /**< Reads suppressed since the UID was processed */
+} dedup_entry_t;
+
+static dedup_entry_t dedupTable[DEDUP_BUCKETS][DEDUP_WAYS];
+static uint32_t passed = 0;
+static uint32_t suppressed = 0;
+static uint32_t evicted = 0;
+
+/** @brief FNV-1a hash of protocol and UID
+ */
+static uint8_t bucketOf(const rfid_tag_t *rfid_tag)
+{
+  uint32_t hash = 2166136261UL;
+
+  hash = (hash ^ rfid_tag->protocol) * 16777619UL;
+  for (uint8_t i = 0; i < rfid_tag->size; i++)
+    hash = (hash ^ rfid_tag->rfid[i]) * 16777619UL;
+
+  return (uint8_t)(hash ^ (hash >> 16)) % DEDUP_BUCKETS;
+}
+
+/** @brief Forget all UIDs
+ */
+void dedupInit(void)
+{
+  memset(dedupTable, 0, sizeof(dedupTable));
+  passed = 0;
+  suppressed = 0;
+  evicted = 0;
+}
+
+/** @brief Check if a read repeats a UID within the hold-off window
+ *  @param rfid_tag Tag just read
+ *  @return true if the same UID was read less than RFID_DEDUP_WINDOW ms ago;
+ *          the read is counted and should not be processed or reported
+ *  @note The window slides: every read of the UID restarts it, so a card
+ *        lingering at the edge of the field stays suppressed
+ */
+bool dedupIsRepeat(const rfid_tag_t *rfid_tag)
+{
+  if (RFID_DEDUP_WINDOW == 0)
+    return false;
+
+  dedup_entry_t *bucket = dedupTable[bucketOf(rfid_tag)];
+  dedup_entry_t *lru = &bucket[0];
+  uint32_t now = halCommonGetInt32uMillisecondTick();
+
+  for (uint8_t i = 0; i < DEDUP_WAYS; i++) {
+    dedup_entry_t *entry = &bucket[i];
+
+    if ((entry->size == rfid_tag->size)
+        && (entry->protocol == rfid_tag->protocol)
+        && (memcmp(entry->rfid, rfid_tag->rfid, rfid_tag->size) == 0)) {
+      bool repeat = (now - entry->lastSeen < RFID_DEDUP_WINDOW);
+
+      entry->lastSeen = now;
+      if (repeat) {
+        entry->repeats++;
+        suppressed++;
+        emberAfCorePrintln("repeat read suppressed (%d)", entry->repeats);
+      }
+      else {
+        entry->repeats = 0;
+        passed++;
+      }
+      return repeat;
+    }
+
+    // Free entries first, then the least recently seen
+    if ((lru->size != 0) && ((entry->size == 0) || (now - entry->lastSeen > now - lru->lastSeen)))
+      lru = entry;
+  }
+
+  if (lru->size != 0)
+    evicted++;
+
+  lru->size = rfid_tag->size;
+  lru->protocol = rfid_tag->protocol;
+  memcpy(lru->rfid, rfid_tag->rfid, rfid_tag->size);
+  lru->lastSeen = now;
+  lru->repeats = 0;
+  passed++;
+  return false;
+
+}
+
+/** @brief Print duplicate suppression counters
+ */
+void dedupPrintStats(void)
+{
+  emberAfCorePrintln("dedup: window %d ms, %d passed, %d suppressed, %d evicted",
+                     RFID_DEDUP_WINDOW, passed, suppressed, evicted);
+}
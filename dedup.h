@@ -0,0 +1,22 @@
+/*
+ * dedup.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef DEDUP_H_
+#define DEDUP_H_
+
+#include "app/framework/include/af.h"
+
+#include "rfid.h"
+
+#define DEDUP_BUCKETS             8
+#define DEDUP_WAYS                4           /**< Entries per bucket; LRU replaced */
+
+void dedupInit(void);
+bool dedupIsRepeat(const rfid_tag_t *rfid_tag);
+void dedupPrintStats(void);
+
+#endif /* DEDUP_H_ */
@@ -0,0 +1,357 @@
+/*
+ * desfire.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "desfire.h"
+
+#include "mbedtls/platform_util.h"
+
+#include "rfid_config.h"
+#include "isodep.h"
+
+#define RND_SIZE                  RFID_AES_BLOCK_SIZE
+#define SV_SIZE                   32
+
+/** @brief Send a native command and check the status byte
+ *  @param cmd Command incl. parameters
+ *  @param len Length of command
+ *  @param resp Buffer for the response (status byte first)
+ *  @param rlen Size of response buffer
+ *  @param status Expected status
+ *  @return Length of response incl. status, or -1 on error
+ */
+static int16_t command(uint8_t *cmd, const uint8_t len, uint8_t *resp, const uint16_t rlen, const uint8_t status)
+{
+  int16_t res = isodepTransceive(cmd, len, resp, rlen);
+
+  if ((res < 1) || (resp[0] != status)) {
+    emberAfCorePrintln("ERROR: desfire command 0x%x failed (0x%x)", cmd[0], (res < 1) ? 0xff : resp[0]);
+    return -1;
+  }
+
+  return res;
+}
+
+/** @brief Rotate a 16 byte block one byte to the left
+ */
+static void rotateLeft(const uint8_t *in, uint8_t *out)
+{
+  memcpy(out, &in[1], RND_SIZE - 1);
+  out[RND_SIZE - 1] = in[0];
+}
+
+/** @brief Truncate a CMAC to 8 bytes (every odd byte)
+ */
+static void truncateMac(const uint8_t *mac, uint8_t *macT)
+{
+  for (uint8_t i = 0; i < DESFIRE_MAC_SIZE; i++)
+    macT[i] = mac[2 * i + 1];
+}
+
+/** @brief Get the hardware type (GET_VERSION)
+ *  @param hwType Set to the hardware type (DESFIRE_HW_TYPE_*)
+ *  @return true if the card answered
+ *  @note Sent ISO7816-4 wrapped, which NTAG 424 DNA also understands. All
+ *        three parts are read so no command is left open.
+ */
+bool desfireGetHwType(uint8_t *hwType)
+{
+  uint8_t cmd[5] = { DESFIRE_CLA_WRAPPED, DESFIRE_CMD_GET_VERSION, 0x00, 0x00, 0x00 };
+  uint8_t resp[32];
+
+  for (uint8_t part = 0; part < 3; part++) {
+    int16_t res = isodepTransceive(cmd, sizeof(cmd), resp, sizeof(resp));
+
+    if ((res < 2) || (resp[res - 2] != DESFIRE_SW1_WRAPPED))
+      return false;
+
+    // Hardware info: vendor ID, type, subtype, ...
+    if (part == 0) {
+      if (res < 4)
+        return false;
+      *hwType = resp[1];
+    }
+
+    if (resp[res - 1] == DESFIRE_STATUS_OK)
+      return true;
+    if (resp[res - 1] != DESFIRE_STATUS_ADDITIONAL_FRAME)
+      return false;
+
+    cmd[1] = DESFIRE_CMD_ADDITIONAL_FRAME;
+  }
+
+  return false;
+
+}
+
+/** @brief Select an application
+ *  @param aid 3 byte application ID
+ *  @return true if selected
+ */
+bool desfireSelectApplication(const uint8_t *aid)
+{
+  uint8_t cmd[1 + DESFIRE_AID_SIZE] = { DESFIRE_CMD_SELECT_APPLICATION };
+  uint8_t resp[1];
+
+  memcpy(&cmd[1], aid, DESFIRE_AID_SIZE);
+  return command(cmd, sizeof(cmd), resp, sizeof(resp), DESFIRE_STATUS_OK) == 1;
+}
+
+/** @brief Diversify an AES key for a card and application (AN10922)
+ *  @param masterKey Master key ID
+ *  @param uid 7 byte UID
+ *  @param uidLen Length of UID
+ *  @param aid 3 byte application ID
+ *  @return Key ID of the diversified (volatile) key, or 0 on error
+ */
+psa_key_id_t desfireDiversifyKey(const psa_key_id_t masterKey, const uint8_t *uid, const uint8_t uidLen, const uint8_t *aid)
+{
+  static const char systemId[] = RFID_DESFIRE_SYSTEM_IDENTIFIER;
+  uint8_t m[1 + 10 + DESFIRE_AID_SIZE + sizeof(systemId)];
+  uint8_t len = 0;
+
+  if (uidLen > 10)
+    return 0;
+
+  // 0x01 || UID || AID || system identifier; CMAC does the padding
+  m[len++] = 0x01;
+  memcpy(&m[len], uid, uidLen);
+  len += uidLen;
+  memcpy(&m[len], aid, DESFIRE_AID_SIZE);
+  len += DESFIRE_AID_SIZE;
+  memcpy(&m[len], systemId, sizeof(systemId) - 1);
+  len += sizeof(systemId) - 1;
+
+  return rfidCryptoDeriveKey(masterKey, m, len);
+}
+
+/** @brief AES mutual authentication (AuthenticateEV2First)
+ *  @param session Session; set up on success
+ *  @param key Key ID (e.g. from desfireDiversifyKey)
+ *  @param keyNo Key number on the card
+ *  @return true if authenticated
+ *  @note All AES operations run through PSA (Secure Engine on MG21)
+ */
+bool desfireAuthenticateEV2First(desfire_session_t *session, const psa_key_id_t key, const uint8_t keyNo)
+{
+  uint8_t buf[1 + 2 * RND_SIZE];
+  uint8_t rndA[RND_SIZE], rndB[RND_SIZE];
+  uint8_t sv[SV_SIZE];
+  bool ok = false;
+
+  memset(session, 0, sizeof(desfire_session_t));
+
+  // Part 1; card returns E(K, RndB)
+  buf[0] = DESFIRE_CMD_AUTH_EV2_FIRST;
+  buf[1] = keyNo;
+  buf[2] = 0x00;
+  if (command(buf, 3, buf, sizeof(buf), DESFIRE_STATUS_ADDITIONAL_FRAME) != 1 + RND_SIZE)
+    return false;
+
+  if (!rfidCryptoAesCbc(key, false, NULL, &buf[1], RND_SIZE, rndB))
+    goto exit;
+
+  // Part 2; send E(K, RndA || RndB')
+  if (psa_generate_random(rndA, RND_SIZE) != PSA_SUCCESS)
+    goto exit;
+
+  buf[0] = DESFIRE_CMD_ADDITIONAL_FRAME;
+  memcpy(&buf[1], rndA, RND_SIZE);
+  rotateLeft(rndB, &buf[1 + RND_SIZE]);
+
+  if (!rfidCryptoAesCbc(key, true, NULL, &buf[1], 2 * RND_SIZE, &buf[1]))
+    goto exit;
+
+  if (command(buf, sizeof(buf), buf, sizeof(buf), DESFIRE_STATUS_OK) != sizeof(buf))
+    goto exit;
+
+  // Card returns E(K, TI || RndA' || PDcap2 || PCDcap2)
+  if (!rfidCryptoAesCbc(key, false, NULL, &buf[1], 2 * RND_SIZE, &buf[1]))
+    goto exit;
+
+  uint8_t rndARot[RND_SIZE];
+  rotateLeft(rndA, rndARot);
+  if (memcmp(&buf[1 + DESFIRE_TI_SIZE], rndARot, RND_SIZE) != 0) {
+    emberAfCorePrintln("ERROR: desfire RndA mismatch");
+    goto exit;
+  }
+
+  memcpy(session->ti, &buf[1], DESFIRE_TI_SIZE);
+
+  // Session vectors; SV1 for the encryption key, SV2 for the MAC key
+  sv[0] = 0xA5; sv[1] = 0x5A; sv[2] = 0x00; sv[3] = 0x01; sv[4] = 0x00; sv[5] = 0x80;
+  sv[6] = rndA[0];
+  sv[7] = rndA[1];
+  for (uint8_t i = 0; i < 6; i++)
+    sv[8 + i] = rndA[2 + i] ^ rndB[i];
+  memcpy(&sv[14], &rndB[6], 10);
+  memcpy(&sv[24], &rndA[8], 8);
+
+  session->encKey = rfidCryptoDeriveKey(key, sv, SV_SIZE);
+
+  sv[0] = 0x5A; sv[1] = 0xA5;
+  session->macKey = rfidCryptoDeriveKey(key, sv, SV_SIZE);
+
+  ok = (session->encKey != 0) && (session->macKey != 0);
+
+exit:
+  mbedtls_platform_zeroize(rndA, sizeof(rndA));
+  mbedtls_platform_zeroize(rndB, sizeof(rndB));
+  mbedtls_platform_zeroize(sv, sizeof(sv));
+
+  if (!ok)
+    desfireEndSession(session);
+
+  return ok;
+
+}
+
+/** @brief Read from a data file in full (encrypted) communication mode
+ *  @param session Authenticated session
+ *  @param fileNo File number
+ *  @param offset Offset in file
+ *  @param len Number of bytes to read (max. DESFIRE_MAX_READ)
+ *  @param buffer Buffer for the plain data
+ *  @return Number of bytes read, or -1 on error
+ */
+int16_t desfireReadData(desfire_session_t *session, const uint8_t fileNo, const uint32_t offset, const uint16_t len, uint8_t *buffer)
+{
+  uint8_t cmd[1 + 7 + DESFIRE_MAC_SIZE];
+  uint8_t resp[1 + DESFIRE_MAX_READ + RFID_AES_BLOCK_SIZE + DESFIRE_MAC_SIZE];
+  uint8_t mac[RFID_AES_BLOCK_SIZE], macT[DESFIRE_MAC_SIZE];
+  uint8_t macInput[1 + 2 + DESFIRE_TI_SIZE + sizeof(resp)];
+  uint8_t iv[RFID_AES_BLOCK_SIZE];
+
+  if ((session->encKey == 0) || (len == 0) || (len > DESFIRE_MAX_READ))
+    return -1;
+
+  // Command header: file number, offset and length (LSB first)
+  cmd[0] = DESFIRE_CMD_READ_DATA;
+  cmd[1] = fileNo;
+  cmd[2] = offset & 0xff;
+  cmd[3] = (offset >> 8) & 0xff;
+  cmd[4] = (offset >> 16) & 0xff;
+  cmd[5] = len & 0xff;
+  cmd[6] = len >> 8;
+  cmd[7] = 0;
+
+  // MAC over Cmd || CmdCtr || TI || CmdHeader
+  macInput[0] = cmd[0];
+  macInput[1] = session->cmdCtr & 0xff;
+  macInput[2] = session->cmdCtr >> 8;
+  memcpy(&macInput[3], session->ti, DESFIRE_TI_SIZE);
+  memcpy(&macInput[3 + DESFIRE_TI_SIZE], &cmd[1], 7);
+
+  if (!rfidCryptoCmac(session->macKey, macInput, 3 + DESFIRE_TI_SIZE + 7, mac))
+    return -1;
+
+  truncateMac(mac, &cmd[8]);
+
+  int16_t res = command(cmd, sizeof(cmd), resp, sizeof(resp), DESFIRE_STATUS_OK);
+  session->cmdCtr++;
+
+  // Encrypted data is padded to whole blocks (0x80 00 ...)
+  uint16_t encLen = (len / RFID_AES_BLOCK_SIZE + 1) * RFID_AES_BLOCK_SIZE;
+  if (res != 1 + encLen + DESFIRE_MAC_SIZE)
+    return -1;
+
+  // Response MAC over RC || CmdCtr || TI || EncData
+  macInput[0] = resp[0];
+  macInput[1] = session->cmdCtr & 0xff;
+  macInput[2] = session->cmdCtr >> 8;
+  memcpy(&macInput[3 + DESFIRE_TI_SIZE], &resp[1], encLen);
+
+  if (!rfidCryptoCmac(session->macKey, macInput, 3 + DESFIRE_TI_SIZE + encLen, mac))
+    return -1;
+
+  truncateMac(mac, macT);
+  if (memcmp(macT, &resp[1 + encLen], DESFIRE_MAC_SIZE) != 0) {
+    emberAfCorePrintln("ERROR: desfire response MAC mismatch");
+    return -1;
+  }
+
+  // IV = E(KSesAuthENC, 0x5A || 0xA5 || TI || CmdCtr || 0...)
+  memset(iv, 0, sizeof(iv));
+  iv[0] = 0x5A;
+  iv[1] = 0xA5;
+  memcpy(&iv[2], session->ti, DESFIRE_TI_SIZE);
+  iv[6] = session->cmdCtr & 0xff;
+  iv[7] = session->cmdCtr >> 8;
+
+  if (!rfidCryptoAesCbc(session->encKey, true, NULL, iv, sizeof(iv), iv))
+    return -1;
+
+  if (!rfidCryptoAesCbc(session->encKey, false, iv, &resp[1], encLen, &resp[1]))
+    return -1;
+
+  memcpy(buffer, &resp[1], len);
+  mbedtls_platform_zeroize(resp, sizeof(resp));
+
+  return len;
+
+}
+
+/** @brief End session; destroys the session keys
+ */
+void desfireEndSession(desfire_session_t *session)
+{
+  rfidCryptoDestroyKey(&session->encKey);
+  rfidCryptoDestroyKey(&session->macKey);
+  session->cmdCtr = 0;
+}
+
+/** @brief Read the configured data file of a selected DESFire card
+ *  @param rfid_tag Selected tag
+ *  @param buffer Buffer for the plain data
+ *  @param len Size of buffer (at least RFID_DESFIRE_LENGTH)
+ *  @return Number of bytes read, DESFIRE_NO_APPLICATION if the card has
+ *          no RFID_DESFIRE_AID, or -1 on error
+ *  @note ISO-DEP must be active (isodepActivate). Selects RFID_DESFIRE_AID
+ *        and authenticates with RFID_DESFIRE_KEY_NO using the stored key
+ *        RFID_DESFIRE_KEY, diversified for the card if
+ *        RFID_DESFIRE_DIVERSIFY is set
+ */
+int16_t desfireReadTag(const rfid_tag_t *rfid_tag, uint8_t *buffer, const uint16_t len)
+{
+  // AIDs are sent LSB first
+  const uint8_t aid[DESFIRE_AID_SIZE] = {
+    RFID_DESFIRE_AID & 0xff,
+    (RFID_DESFIRE_AID >> 8) & 0xff,
+    (RFID_DESFIRE_AID >> 16) & 0xff
+  };
+  desfire_session_t session;
+  psa_key_id_t key = RFID_KEY_ID(RFID_DESFIRE_KEY);
+  int16_t res = -1;
+
+  if (len < RFID_DESFIRE_LENGTH)
+    return -1;
+
+  if (!desfireSelectApplication(aid))
+    return DESFIRE_NO_APPLICATION;
+
+#if RFID_DESFIRE_DIVERSIFY
+  key = desfireDiversifyKey(key, rfid_tag->rfid, rfid_tag->size, aid);
+  if (key == 0)
+    return -1;
+#else
+  (void)rfid_tag;
+#endif
+
+  if (desfireAuthenticateEV2First(&session, key, RFID_DESFIRE_KEY_NO)) {
+    res = desfireReadData(&session, RFID_DESFIRE_FILE, 0, RFID_DESFIRE_LENGTH, buffer);
+    desfireEndSession(&session);
+  }
+
+#if RFID_DESFIRE_DIVERSIFY
+  rfidCryptoDestroyKey(&key);
+#endif
+
+  if (res < 0)
+    emberAfCorePrintln("ERROR: desfire read of file %d failed", RFID_DESFIRE_FILE);
+
+  return res;
+
+}
@@ -0,0 +1,63 @@
+/*
+ * desfire.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef DESFIRE_H_
+#define DESFIRE_H_
+
+#include "app/framework/include/af.h"
+
+#include "rfid.h"
+#include "rfid_crypto.h"
+
+#define DESFIRE_AID_SIZE          3
+#define DESFIRE_TI_SIZE           4
+#define DESFIRE_MAC_SIZE          8
+#define DESFIRE_MAX_READ          192         /**< Max. bytes per encrypted read */
+
+/*! desfireReadTag result if RFID_DESFIRE_AID is not on the card */
+#define DESFIRE_NO_APPLICATION    (-2)
+
+/*! ISO7816-4 wrapping of native commands (CLA, status word 0x91 xx) */
+#define DESFIRE_CLA_WRAPPED       0x90
+#define DESFIRE_SW1_WRAPPED       0x91
+
+/*! GET_VERSION hardware type */
+#define DESFIRE_HW_TYPE_DESFIRE   0x01
+#define DESFIRE_HW_TYPE_NTAG      0x04        /**< NTAG 424 DNA (same ATQA/SAK as DESFire) */
+
+/*! DESFire native commands */
+enum desfire_cmd {
+  DESFIRE_CMD_AUTH_EV2_FIRST = 0x71,
+  DESFIRE_CMD_GET_VERSION = 0x60,
+  DESFIRE_CMD_SELECT_APPLICATION = 0x5A,
+  DESFIRE_CMD_READ_DATA = 0xAD,
+  DESFIRE_CMD_ADDITIONAL_FRAME = 0xAF
+};
+
+/*! DESFire status codes */
+enum desfire_status {
+  DESFIRE_STATUS_OK = 0x00,
+  DESFIRE_STATUS_ADDITIONAL_FRAME = 0xAF
+};
+
+/*! EV2 secure messaging session; keys live in the PSA key store */
+typedef struct {
+  psa_key_id_t encKey;
+  psa_key_id_t macKey;
+  uint8_t ti[DESFIRE_TI_SIZE];
+  uint16_t cmdCtr;
+} desfire_session_t;
+
+bool desfireGetHwType(uint8_t *hwType);
+bool desfireSelectApplication(const uint8_t *aid);
+psa_key_id_t desfireDiversifyKey(psa_key_id_t masterKey, const uint8_t *uid, uint8_t uidLen, const uint8_t *aid);
+bool desfireAuthenticateEV2First(desfire_session_t *session, psa_key_id_t key, uint8_t keyNo);
+int16_t desfireReadData(desfire_session_t *session, uint8_t fileNo, uint32_t offset, uint16_t len, uint8_t *buffer);
+void desfireEndSession(desfire_session_t *session);
+int16_t desfireReadTag(const rfid_tag_t *rfid_tag, uint8_t *buffer, uint16_t len);
+
+#endif /* DESFIRE_H_ */
@@ -0,0 +1,146 @@
+/*
+ * duty.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "duty.h"
+
+#include "rfid_config.h"
+
+#define MS_PER_HOUR               3600000UL
+#define MS_PER_DAY                (24 * MS_PER_HOUR)
+#define ACTIVE_HOLD_MS            ((uint32_t)RFID_LPCD_ACTIVE_HOLD * 1000UL)
+#define BACKOFF_STEP_MS           ((uint32_t)RFID_LPCD_BACKOFF_STEP * 1000UL)
+
+static uint32_t lastActivity = 0;             /**< ms tick of the last read; boot counts as activity */
+static uint16_t armedMs = RFID_LPCD_PERIOD_MIN;
+static uint32_t arms[2] = { 0, 0 };           /**< Re-arms at the fastest / a slower period */
+
+/* Time of day, only known after dutySetClock */
+static bool clockSet = false;
+static uint32_t clockTick = 0;                /**< ms tick at clockMs */
+static uint32_t clockMs = 0;                  /**< ms since midnight at clockTick */
+
+/** @brief Milliseconds since midnight
+ *  @note Moves the reference forward a day at a time so the tick difference
+ *        never wraps
+ */
+static uint32_t timeOfDay(const uint32_t now)
+{
+  while (now - clockTick >= MS_PER_DAY)
+    clockTick += MS_PER_DAY;
+
+  return (clockMs + (now - clockTick)) % MS_PER_DAY;
+}
+
+/** @brief Check for the configured busy hours
+ */
+static bool busyHours(const uint32_t now)
+{
+  if (!clockSet || (RFID_LPCD_BUSY_START == RFID_LPCD_BUSY_END))
+    return false;
+
+  int hour = (int)(timeOfDay(now) / MS_PER_HOUR);
+
+  if (RFID_LPCD_BUSY_START < RFID_LPCD_BUSY_END)
+    return (hour >= RFID_LPCD_BUSY_START) && (hour < RFID_LPCD_BUSY_END);
+
+  // Busy hours across midnight
+  return (hour >= RFID_LPCD_BUSY_START) || (hour < RFID_LPCD_BUSY_END);
+}
+
+/** @brief Power-down period for a point in time
+ *  @note RFID_LPCD_PERIOD_MIN during busy hours and for RFID_LPCD_ACTIVE_HOLD
+ *        after a read, then doubled every RFID_LPCD_BACKOFF_STEP up to
+ *        RFID_LPCD_PERIOD_MAX
+ */
+static uint16_t periodAt(const uint32_t now)
+{
+  uint32_t idle = now - lastActivity;
+
+  if (busyHours(now) || (idle < ACTIVE_HOLD_MS))
+    return RFID_LPCD_PERIOD_MIN;
+
+  uint32_t steps = (idle - ACTIVE_HOLD_MS) / BACKOFF_STEP_MS + 1;
+  uint32_t period = RFID_LPCD_PERIOD_MIN;
+
+  while ((steps-- > 0) && (period < RFID_LPCD_PERIOD_MAX))
+    period <<= 1;
+
+  return (period > RFID_LPCD_PERIOD_MAX) ? RFID_LPCD_PERIOD_MAX : (uint16_t)period;
+}
+
+/** @brief Note a tag read; polling goes back to the fastest period
+ */
+void dutyActivity(void)
+{
+  lastActivity = halCommonGetInt32uMillisecondTick();
+}
+
+/** @brief Power-down period for the LPCD being armed now
+ *  @return Period in ms
+ *  @note The value is remembered as the armed period for dutyChanged
+ */
+uint16_t dutyPowerDownMs(void)
+{
+  armedMs = periodAt(halCommonGetInt32uMillisecondTick());
+  arms[armedMs > RFID_LPCD_PERIOD_MIN]++;
+  return armedMs;
+}
+
+/** @brief Check if LPCD should be re-armed with another period
+ */
+bool dutyChanged(void)
+{
+  return periodAt(halCommonGetInt32uMillisecondTick()) != armedMs;
+}
+
+/** @brief Time until the power-down period may change without a read
+ *  @return ms, or 0 if it stays as is until the next read
+ */
+uint32_t dutyNextChangeMs(void)
+{
+  uint32_t now = halCommonGetInt32uMillisecondTick();
+  uint32_t idle = now - lastActivity;
+  uint32_t next = 0;
+
+  if (idle < ACTIVE_HOLD_MS)
+    next = ACTIVE_HOLD_MS - idle;
+  else if (periodAt(now) < RFID_LPCD_PERIOD_MAX)
+    next = BACKOFF_STEP_MS - ((idle - ACTIVE_HOLD_MS) % BACKOFF_STEP_MS);
+
+  // Busy hours start and end on the hour
+  if (clockSet && (RFID_LPCD_BUSY_START != RFID_LPCD_BUSY_END)) {
+    uint32_t toHour = MS_PER_HOUR - (timeOfDay(now) % MS_PER_HOUR);
+    if ((next == 0) || (toHour < next))
+      next = toHour;
+  }
+
+  return next;
+}
+
+/** @brief Set the time of day used for the busy hours
+ *  @param hour 0..23
+ *  @param minute 0..59
+ *  @note Not kept over a reset; busy hours are ignored until it is set
+ */
+void dutySetClock(const uint8_t hour, const uint8_t minute)
+{
+  clockTick = halCommonGetInt32uMillisecondTick();
+  clockMs = ((uint32_t)(hour % 24) * 60 + (minute % 60)) * 60000UL;
+  clockSet = true;
+}
+
+/** @brief Print the armed period and re-arm counters
+ */
+void dutyPrintStats(void)
+{
+  uint32_t now = halCommonGetInt32uMillisecondTick();
+
+  emberAfCorePrintln("duty: armed %d ms (%d..%d), idle %d s, busy hours %s",
+                     armedMs, RFID_LPCD_PERIOD_MIN, RFID_LPCD_PERIOD_MAX,
+                     (now - lastActivity) / 1000, busyHours(now) ? "yes" : (clockSet ? "no" : "clock not set"));
+  emberAfCorePrintln("duty: %d arms at %d ms, %d slower", arms[0], RFID_LPCD_PERIOD_MIN, arms[1]);
+}
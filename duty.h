@@ -0,0 +1,23 @@
+/*
+ * duty.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef DUTY_H_
+#define DUTY_H_
+
+#include "app/framework/include/af.h"
+
+/*! T4 runs from the 2 kHz LFO during LPCD power-down */
+#define DUTY_T4_TICKS_PER_MS      2
+
+void dutyActivity(void);
+uint16_t dutyPowerDownMs(void);
+bool dutyChanged(void);
+uint32_t dutyNextChangeMs(void);
+void dutySetClock(uint8_t hour, uint8_t minute);
+void dutyPrintStats(void);
+
+#endif /* DUTY_H_ */
@@ -0,0 +1,126 @@
+/*
+ * encode.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "encode.h"
+
+#include "tagtype.h"
+
+/* Image written from page 4; padded with zeros to whole pages */
+static uint8_t image[ENCODE_IMAGE_MAX];
+static uint8_t verify[ENCODE_IMAGE_MAX];
+static uint16_t imageLength = 0;
+static bool lockTags = false;
+static bool active = false;
+
+static uint32_t encoded = 0;
+static uint32_t failed = 0;
+
+/** @brief Copy part of the image to write
+ *  @param offset Offset in the image (0 = first byte of page 4)
+ *  @param data Image data
+ *  @param len Length of data
+ *  @return true if the data fits in the image
+ */
+bool encodeLoad(const uint16_t offset, const uint8_t *data, const uint16_t len)
+{
+  if ((uint32_t)offset + len > ENCODE_IMAGE_MAX)
+    return false;
+
+  memcpy(&image[offset], data, len);
+  return true;
+}
+
+/** @brief Enter encoding mode; every tag that arrives is encoded
+ *  @param len Image length (bytes)
+ *  @param lock Lock each tag after a verified write
+ *  @return true if started
+ */
+bool encodeStart(const uint16_t len, const bool lock)
+{
+  if ((len == 0) || (len > ENCODE_IMAGE_MAX))
+    return false;
+
+  imageLength = len;
+  lockTags = lock;
+  active = true;
+  encoded = 0;
+  failed = 0;
+
+  // Pad the last page
+  memset(&image[len], 0, (NTAG_PAGE_SIZE - len % NTAG_PAGE_SIZE) % NTAG_PAGE_SIZE);
+  return true;
+}
+
+/** @brief Leave encoding mode
+ */
+void encodeStop(void)
+{
+  active = false;
+  emberAfCorePrintln("encode: stopped, %d ok, %d failed", encoded, failed);
+}
+
+bool encodeActive(void)
+{
+  return active;
+}
+
+/** @brief Print the result record of a tag
+ */
+static bool encodeRecord(const rfid_tag_t *rfid_tag, const char *result, const uint8_t pages, const uint32_t start)
+{
+  bool ok = (result == NULL);
+
+  if (ok)
+    encoded++;
+  else
+    failed++;
+
+  emberAfCorePrint("encode:");
+  for (uint8_t i = 0; i < rfid_tag->size; i++)
+    emberAfCorePrint(" %x", rfid_tag->rfid[i]);
+  emberAfCorePrintln(" %s, %d pages, %d ms, %d ok, %d failed",
+                     ok ? "ok" : result, pages, halCommonGetInt32uMillisecondTick() - start,
+                     encoded, failed);
+  return ok;
+}
+
+/** @brief Write the image to a tag, verify it and optionally lock it
+ *  @param rfid_tag Selected tag
+ *  @return true if encoded
+ *  @note Pages are written back to back and verified with a single
+ *        FAST_READ over the written range, not a READ after every WRITE
+ */
+bool encodeTag(const rfid_tag_t *rfid_tag)
+{
+  uint32_t start = halCommonGetInt32uMillisecondTick();
+  uint8_t pages = (imageLength + NTAG_PAGE_SIZE - 1) / NTAG_PAGE_SIZE;
+  ntag_info_t info;
+
+  if (tagTypeClassify(rfid_tag) != TAG_FAMILY_ULTRALIGHT)
+    return encodeRecord(rfid_tag, "not NTAG", 0, start);
+
+  if (!ntagGetVersion(&info))
+    return encodeRecord(rfid_tag, "no GET_VERSION", 0, start);
+
+  if (pages > ntagUserPages(&info))
+    return encodeRecord(rfid_tag, "image too large", 0, start);
+
+  for (uint8_t i = 0; i < pages; i++) {
+    if (!ntagWritePage(NTAG_USER_START_PAGE + i, &image[i * NTAG_PAGE_SIZE]))
+      return encodeRecord(rfid_tag, "write failed", i, start);
+  }
+
+  if ((ntagReadPages(&info, NTAG_USER_START_PAGE, pages, verify) != pages * NTAG_PAGE_SIZE)
+      || (memcmp(verify, image, pages * NTAG_PAGE_SIZE) != 0))
+    return encodeRecord(rfid_tag, "verify failed", pages, start);
+
+  if (lockTags && !ntagLock(&info))
+    return encodeRecord(rfid_tag, "lock failed", pages, start);
+
+  return encodeRecord(rfid_tag, NULL, pages, start);
+
+}
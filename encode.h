@@ -0,0 +1,25 @@
+/*
+ * encode.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef ENCODE_H_
+#define ENCODE_H_
+
+#include "app/framework/include/af.h"
+
+#include "rfid.h"
+#include "ntag.h"
+
+/*! Largest image; NTAG216 user memory */
+#define ENCODE_IMAGE_MAX          (222 * NTAG_PAGE_SIZE)
+
+bool encodeLoad(uint16_t offset, const uint8_t *data, uint16_t len);
+bool encodeStart(uint16_t len, bool lock);
+void encodeStop(void);
+bool encodeActive(void);
+bool encodeTag(const rfid_tag_t *rfid_tag);
+
+#endif /* ENCODE_H_ */
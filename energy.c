@@ -0,0 +1,244 @@
+/*
+ * energy.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "energy.h"
+
+#include "sl_power_manager.h"
+#include "sl_sleeptimer.h"
+
+#include "report.h"
+#include "rfid_config.h"
+#include "zigbee_device_config.h"
+
+#define ENERGY_MODES              4           /**< EM0..EM3 */
+#define SECONDS_PER_DAY           86400UL
+
+/* Only a sleepy end device polls its parent; a router keeps the receiver on */
+#define ENERGY_PARENT_POLLS       (SLI_ZIGBEE_PRIMARY_NETWORK_DEVICE_TYPE == SLI_ZIGBEE_NETWORK_DEVICE_TYPE_SLEEPY_END_DEVICE)
+
+static const char *phaseNames[ENERGY_PHASES] = { "lpcd arm", "field", "i2c", "radio" };
+
+/* Energy mode residency in sleeptimer ticks, updated by the power manager */
+static uint64_t emTicks[ENERGY_MODES];
+static uint64_t emSince = 0;
+static uint8_t emCurrent = SL_POWER_MANAGER_EM0;
+static sl_power_manager_em_transition_event_handle_t emHandle;
+
+/* Phases; nested begin/end of the same phase count once */
+static uint64_t phaseTicks[ENERGY_PHASES];
+static uint64_t phaseSince[ENERGY_PHASES];
+static uint8_t phaseDepth[ENERGY_PHASES];
+
+/* LPCD detections, counted from the armed power-down period */
+static uint64_t lpcdSince = 0;
+static uint16_t lpcdPeriodMs = 0;
+static uint32_t detections = 0;
+
+static uint64_t startTick = 0;
+static uint32_t taps = 0;
+static uint32_t transmissions = 0;
+
+static sl_zigbee_event_t energyEvent;
+
+/** @brief Power manager transition hook; books the time in the mode left
+ */
+static void emTransition(sl_power_manager_em_t from, sl_power_manager_em_t to)
+{
+  uint64_t now = sl_sleeptimer_get_tick_count64();
+
+  if ((uint8_t)from < ENERGY_MODES)
+    emTicks[from] += now - emSince;
+  emSince = now;
+  emCurrent = (uint8_t)to;
+}
+
+static const sl_power_manager_em_transition_event_info_t emInfo = {
+  .event_mask = SL_POWER_MANAGER_EVENT_TRANSITION_LEAVING_EM0
+                | SL_POWER_MANAGER_EVENT_TRANSITION_LEAVING_EM1
+                | SL_POWER_MANAGER_EVENT_TRANSITION_LEAVING_EM2
+                | SL_POWER_MANAGER_EVENT_TRANSITION_LEAVING_EM3,
+  .on_event = emTransition,
+};
+
+/** @brief Charge of a current over a number of ticks
+ *  @return uC
+ */
+static uint64_t charge(const uint32_t microAmps, const uint64_t ticks)
+{
+  return (uint64_t)microAmps * ticks / sl_sleeptimer_get_timer_frequency();
+}
+
+/** @brief Residency per energy mode, including the interval still open
+ *  @param ticks Set to the ticks spent in each mode
+ */
+static void emResidency(uint64_t *ticks, const uint64_t now)
+{
+  memcpy(ticks, emTicks, sizeof(emTicks));
+  if (emCurrent < ENERGY_MODES)
+    ticks[emCurrent] += now - emSince;
+}
+
+/** @brief Close the current LPCD interval
+ */
+static void countDetections(const uint64_t now)
+{
+  if (lpcdPeriodMs == 0)
+    return;
+
+  uint64_t ms = (now - lpcdSince) * 1000 / sl_sleeptimer_get_timer_frequency();
+  detections += (uint32_t)(ms / lpcdPeriodMs);
+  lpcdSince = now;
+}
+
+/** @brief Estimated charge since start
+ *  @param tapCharge Set to the part spent on tags (reader phases and radio)
+ *  @return uC
+ */
+static uint64_t totalCharge(uint64_t *tapCharge)
+{
+  uint64_t now = sl_sleeptimer_get_tick_count64();
+  uint64_t uptime = now - startTick;
+  uint64_t arm = phaseTicks[ENERGY_PHASE_LPCD_ARM];
+  uint64_t field = phaseTicks[ENERGY_PHASE_FIELD];
+  uint64_t standby = (uptime > arm + field) ? uptime - arm - field : 0;
+  uint64_t residency[ENERGY_MODES];
+  uint64_t mcu, idle, tx;
+
+  countDetections(now);
+  emResidency(residency, now);
+
+  mcu = charge(RFID_ENERGY_EM0_UA, residency[0])
+        + charge(RFID_ENERGY_EM1_UA, residency[1])
+        + charge(RFID_ENERGY_EM2_UA, residency[2] + residency[3]);
+
+  // Reader standby, LPCD detections and parent polls go on regardless of taps
+  idle = charge(RFID_ENERGY_READER_STANDBY_UA, standby)
+         + (uint64_t)detections * RFID_ENERGY_LPCD_DETECT_NC / 1000;
+#if ENERGY_PARENT_POLLS
+  idle += charge(RFID_ENERGY_POLL_UC, uptime) / RFID_ENERGY_POLL_INTERVAL;
+#endif
+
+  tx = (uint64_t)transmissions * RFID_ENERGY_TX_UC;
+
+  // Reader phases, radio and the MCU kept in EM0 for them
+  *tapCharge = charge(RFID_ENERGY_FIELD_UA, field)
+               + charge(RFID_ENERGY_READER_ACTIVE_UA, arm)
+               + tx
+               + charge(RFID_ENERGY_EM0_UA, arm + field + phaseTicks[ENERGY_PHASE_RADIO]);
+
+  // EM0 during the phases is already in the residency
+  return mcu + idle + *tapCharge - charge(RFID_ENERGY_EM0_UA, arm + field + phaseTicks[ENERGY_PHASE_RADIO]);
+}
+
+/** @brief Charge per day at the rate seen since start
+ *  @return uAh
+ */
+static uint32_t chargePerDay(const uint64_t total)
+{
+  uint64_t seconds = (sl_sleeptimer_get_tick_count64() - startTick) / sl_sleeptimer_get_timer_frequency();
+
+  if (seconds == 0)
+    return 0;
+
+  // uC/s * s/day / (3600 uC/uAh)
+  return (uint32_t)(total * SECONDS_PER_DAY / seconds / 3600);
+}
+
+/** @brief Send the estimate every RFID_ENERGY_REPORT_INTERVAL hours
+ */
+static void energyEventHandler(sl_zigbee_event_t *event)
+{
+  uint64_t tapCharge;
+  uint64_t total = totalCharge(&tapCharge);
+
+  sl_zigbee_event_set_inactive(event);
+  reportEnergy(chargePerDay(total), taps ? (uint32_t)(tapCharge / taps) : 0, taps);
+  sl_zigbee_event_set_delay_ms(event, RFID_ENERGY_REPORT_INTERVAL * 3600000UL);
+}
+
+/** @brief Start accounting
+ *  @note Call early in app_init; earlier time is not accounted
+ */
+void energyInit(void)
+{
+  startTick = sl_sleeptimer_get_tick_count64();
+  emSince = startTick;
+  sl_power_manager_subscribe_em_transition_event(&emHandle, &emInfo);
+
+  sl_zigbee_event_init(&energyEvent, energyEventHandler);
+  if (RFID_ENERGY_REPORT_INTERVAL > 0)
+    sl_zigbee_event_set_delay_ms(&energyEvent, RFID_ENERGY_REPORT_INTERVAL * 3600000UL);
+}
+
+/** @brief Start timing a phase
+ */
+void energyPhaseBegin(const energy_phase_t phase)
+{
+  uint64_t now = sl_sleeptimer_get_tick_count64();
+
+  // LPCD stops while the reader is used
+  if (phase == ENERGY_PHASE_FIELD) {
+    countDetections(now);
+    lpcdPeriodMs = 0;
+  }
+
+  if (phaseDepth[phase]++ == 0)
+    phaseSince[phase] = now;
+}
+
+/** @brief Stop timing a phase
+ */
+void energyPhaseEnd(const energy_phase_t phase)
+{
+  if ((phaseDepth[phase] > 0) && (--phaseDepth[phase] == 0))
+    phaseTicks[phase] += sl_sleeptimer_get_tick_count64() - phaseSince[phase];
+}
+
+/** @brief LPCD was armed with a power-down period
+ */
+void energyLpcdArmed(const uint16_t periodMs)
+{
+  uint64_t now = sl_sleeptimer_get_tick_count64();
+
+  countDetections(now);
+  lpcdSince = now;
+  lpcdPeriodMs = periodMs;
+}
+
+/** @brief Count a tag read
+ */
+void energyTap(void)
+{
+  taps++;
+}
+
+/** @brief Count a report transmission
+ */
+void energyTx(void)
+{
+  transmissions++;
+}
+
+/** @brief Print residency, phase times and the charge estimate
+ */
+void energyPrintStats(void)
+{
+  uint32_t frequency = sl_sleeptimer_get_timer_frequency();
+  uint64_t residency[ENERGY_MODES];
+  uint64_t tapCharge;
+  uint64_t total = totalCharge(&tapCharge);
+
+  emResidency(residency, sl_sleeptimer_get_tick_count64());
+  emberAfCorePrintln("energy: EM0 %d ms, EM1 %d ms, EM2 %d ms, EM3 %d ms",
+                     (uint32_t)(residency[0] * 1000 / frequency), (uint32_t)(residency[1] * 1000 / frequency),
+                     (uint32_t)(residency[2] * 1000 / frequency), (uint32_t)(residency[3] * 1000 / frequency));
+  for (uint8_t i = 0; i < ENERGY_PHASES; i++)
+    emberAfCorePrintln("energy: %s %d ms", phaseNames[i], (uint32_t)(phaseTicks[i] * 1000 / frequency));
+  emberAfCorePrintln("energy: %d LPCD detections, %d taps, %d transmissions", detections, taps, transmissions);
+  emberAfCorePrintln("energy: %d uC total, %d uC per tap, %d uAh per day",
+                     (uint32_t)total, taps ? (uint32_t)(tapCharge / taps) : 0, chargePerDay(total));
+}
@@ -0,0 +1,30 @@
+/*
+ * energy.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef ENERGY_H_
+#define ENERGY_H_
+
+#include "app/framework/include/af.h"
+
+/*! Timed reader and radio phases */
+typedef enum {
+  ENERGY_PHASE_LPCD_ARM,                      /**< LPCD setup and re-arm, field off */
+  ENERGY_PHASE_FIELD,                         /**< Field on: probe, read, presence probes */
+  ENERGY_PHASE_I2C,                           /**< Waiting for I2C transfers (part of the above) */
+  ENERGY_PHASE_RADIO,                         /**< Sending reports */
+  ENERGY_PHASES
+} energy_phase_t;
+
+void energyInit(void);
+void energyPhaseBegin(energy_phase_t phase);
+void energyPhaseEnd(energy_phase_t phase);
+void energyLpcdArmed(uint16_t periodMs);
+void energyTap(void);
+void energyTx(void);
+void energyPrintStats(void);
+
+#endif /* ENERGY_H_ */
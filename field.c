@@ -0,0 +1,57 @@
+/*
+ * field.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "field.h"
+
+#include "em_gpio.h"
+
+#include "energy.h"
+#include "rfid.h"
+#include "rfid_config.h"
+
+// 5V control
+#define ENABLE_5V_PORT          gpioPortD
+#define ENABLE_5V_PIN           3
+
+static uint32_t fieldOnAt = 0;
+
+/** @brief Configure the 5V control pin
+ *  @note The rail starts on only if LPCD needs it
+ */
+void fieldInit(void)
+{
+  GPIO_PinModeSet(ENABLE_5V_PORT, ENABLE_5V_PIN, gpioModePushPull, RFID_RAIL_LPCD);
+}
+
+/** @brief Power up for a read: switch the 5V rail on and start timing the field
+ *  @note The field itself is switched on by rfidInit / rfidLoadProtocol
+ */
+void fieldBegin(void)
+{
+  if (!GPIO_PinOutGet(ENABLE_5V_PORT, ENABLE_5V_PIN)) {
+    GPIO_PinOutSet(ENABLE_5V_PORT, ENABLE_5V_PIN);
+    halCommonDelayMilliseconds(RFID_RAIL_SETTLE_MS);
+  }
+
+  energyPhaseBegin(ENERGY_PHASE_FIELD);
+  fieldOnAt = halCommonGetInt32uMillisecondTick();
+}
+
+/** @brief Switch the field off after the last exchange and the 5V rail
+ *         unless LPCD needs it
+ *  @return Time since fieldBegin (ms)
+ */
+uint32_t fieldEnd(void)
+{
+  rfidFieldOff();
+  energyPhaseEnd(ENERGY_PHASE_FIELD);
+
+  if (!RFID_RAIL_LPCD)
+    GPIO_PinOutClear(ENABLE_5V_PORT, ENABLE_5V_PIN);
+
+  return halCommonGetInt32uMillisecondTick() - fieldOnAt;
+}
@@ -0,0 +1,17 @@
+/*
+ * field.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef FIELD_H_
+#define FIELD_H_
+
+#include "app/framework/include/af.h"
+
+void fieldInit(void);
+void fieldBegin(void);
+uint32_t fieldEnd(void);
+
+#endif /* FIELD_H_ */
@@ -10,6 +10,7 @@
 #include "em_i2c.h"
 #include "em_wdog.h"
 
+#include "energy.h"
 #include "rfid.h"
 
 /** @brief Print I2C error
@@ -43,25 +44,38 @@ static void printI2CError(const int code)
 
 }
 
-static EmberStatus doTransfer(I2C_TypeDef* i2c, I2C_TransferSeq_TypeDef* seq, const uint8_t maxAttempts)
+/*! Transfer timeout: bus setup plus about twice the byte time at 100 kHz or more */
+#define I2C_TIMEOUT_BASE_MS       2
+#define I2C_TIMEOUT_BYTES_PER_MS  5
+
+/** @brief Run a transfer to completion
+ *  @param seq Transfer sequence
+ *  @param len Number of data bytes in the sequence (sets the timeout)
+ *  @note emlib advances by one bus event per I2C_Transfer call, so the
+ *        transfer is polled without delay and timed out on elapsed time
+ */
+static EmberStatus doTransfer(I2C_TypeDef* i2c, I2C_TransferSeq_TypeDef* seq, const uint16_t len)
 {
-  int count = 0;
+  uint32_t timeout = I2C_TIMEOUT_BASE_MS + len / I2C_TIMEOUT_BYTES_PER_MS;
+  uint32_t start = halCommonGetInt32uMillisecondTick();
 
   // Initialize transfer
-  I2C_TransferReturn_TypeDef sta = I2C_TransferInit(I2C0, seq);
+  I2C_TransferReturn_TypeDef sta = I2C_TransferInit(i2c, seq);
 
-  // Do transfer until done or "timeout"
-  while (sta == i2cTransferInProgress && count++ < maxAttempts) {
-    halCommonDelayMilliseconds(1);
-    sta = I2C_Transfer(I2C0);
+  // Do transfer until done or timeout
+  energyPhaseBegin(ENERGY_PHASE_I2C);
+  while (sta == i2cTransferInProgress
+         && elapsedTimeInt32u(start, halCommonGetInt32uMillisecondTick()) <= timeout) {
+    sta = I2C_Transfer(i2c);
   }
+  energyPhaseEnd(ENERGY_PHASE_I2C);
 
   // Check result
   if (sta == i2cTransferDone) {
     return EMBER_SUCCESS;
   }
   else if (sta == i2cTransferInProgress) {
-    emberAfCorePrintln("I2C transfer failed (max. attempts reached)");
+    emberAfCorePrintln("I2C transfer failed (timeout)");
     return EMBER_ERR_FATAL;
   }
   else {
@@ -81,7 +95,7 @@ EmberStatus i2cRead(const uint8_t address, uint8_t* rbuf, const uint8_t rlen)
   seq.buf[0].data = rbuf;
   seq.buf[0].len = rlen;
 
-  return doTransfer(I2C0, &seq, 25);
+  return doTransfer(I2C0, &seq, rlen);
 
 }
 
@@ -94,7 +108,7 @@ EmberStatus i2cWrite(const uint8_t address, uint8_t* wbuf, const uint8_t wlen)
   seq.buf[0].data = wbuf;
   seq.buf[0].len = wlen;
 
-  return doTransfer(I2C0, &seq, 25);
+  return doTransfer(I2C0, &seq, wlen);
 
 }
 
@@ -121,7 +135,7 @@ EmberStatus i2cTransaction(const uint8_t address, uint8_t* wbuf, const uint8_t w
   seq.buf[1].data = rbuf;
   seq.buf[1].len = rlen;
 
-  return doTransfer(I2C0, &seq, 25);
+  return doTransfer(I2C0, &seq, wlen + rlen);
 
 }
 
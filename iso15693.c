@@ -0,0 +1,172 @@
+/*
+ * iso15693.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "iso15693.h"
+
+/* Response time is roughly 302 us (64 T0 ticks) per byte at 26 kbit/s */
+#define ISO15693_TIMEOUT(bytes)   (200 + (bytes) * 70)
+
+/* Inventory response: flags, DSFID and UID */
+#define INVENTORY_RESPONSE_SIZE   (2 + ISO15693_UID_SIZE)
+
+/* Max. mask length (UID is 64 bits, 4 bits resolved per round) */
+#define MAX_MASK_BITS             60
+
+/* One level per mask length that can still collide (0, 4, ... 56 bits) */
+#define MAX_PENDING_MASKS         (MAX_MASK_BITS / 4)
+
+typedef struct {
+  uint8_t bits;                               /**< Mask length in bits */
+  uint8_t mask[ISO15693_UID_SIZE];            /**< Mask value (LSB first) */
+  uint16_t collided;                          /**< Slots of the round with this mask still to resolve */
+} inventory_mask_t;
+
+/** @brief Check if a UID is already in the result list
+ */
+static bool haveTag(const rfid_tag_t *tags, const uint8_t count, const uint8_t *uid)
+{
+  for (uint8_t i = 0; i < count; i++) {
+    if (memcmp(tags[i].rfid, uid, ISO15693_UID_SIZE) == 0)
+      return true;
+  }
+  return false;
+}
+
+/** @brief Run one 16 slot inventory round
+ *  @param mask Mask the UIDs must match
+ *  @param tags Result list
+ *  @param count Number of tags in result list; updated on return
+ *  @param maxTags Size of result list
+ *  @return Bit per slot in which several tags answered
+ *  @note Slots are advanced by sending an EOF only
+ */
+static uint16_t inventoryRound(const inventory_mask_t *mask, rfid_tag_t *tags, uint8_t *count, const uint8_t maxTags)
+{
+  uint8_t req[3 + ISO15693_UID_SIZE] = { ISO15693_FLAG_DATA_RATE | ISO15693_FLAG_INVENTORY,
+                                         ISO15693_CMD_INVENTORY,
+                                         mask->bits };
+  uint8_t maskBytes = (mask->bits + 7) / 8;
+  uint8_t resp[INVENTORY_RESPONSE_SIZE];
+  uint16_t collided = 0;
+
+  memcpy(&req[3], mask->mask, maskBytes);
+
+  for (uint8_t slot = 0; slot < ISO15693_SLOTS; slot++) {
+    uint8_t error;
+    int16_t len;
+
+    // First slot starts with the request, the rest with an EOF
+    if (slot == 0)
+      len = rfidExchange(req, 3 + maskBytes, resp, sizeof(resp), ISO15693_TIMEOUT(sizeof(resp)), &error);
+    else
+      len = rfidExchange(NULL, 0, resp, sizeof(resp), ISO15693_TIMEOUT(sizeof(resp)), &error);
+
+    if (len == INVENTORY_RESPONSE_SIZE && !(resp[0] & ISO15693_FLAG_ERROR)) {
+      uint8_t *uid = &resp[2];
+      if ((*count < maxTags) && !haveTag(tags, *count, uid)) {
+        rfid_tag_t *tag = &tags[*count];
+        memset(tag, 0, sizeof(rfid_tag_t));
+        memcpy(tag->rfid, uid, ISO15693_UID_SIZE);
+        tag->size = ISO15693_UID_SIZE;
+        tag->protocol = MFRC630_PROTO_ISO15693;
+        (*count)++;
+      }
+    }
+    else if ((error & (MFRC630_ERROR_COLLDET | MFRC630_ERROR_INTEG)) && (mask->bits < MAX_MASK_BITS)) {
+      // Several tags answered in this slot; resolved with a longer mask later
+      collided |= 1 << slot;
+    }
+  }
+
+  return collided;
+
+}
+
+/** @brief ISO15693 inventory with 16 slot anticollision
+ *  @param tags Result list
+ *  @param maxTags Size of result list
+ *  @return Number of tags found
+ *  @note Switches the reader to ISO15693; the caller has to switch back.
+ *        Collided slots are resolved depth first, one mask level at a time,
+ *        so the pending list never holds more than MAX_PENDING_MASKS entries
+ *        and no slot is dropped.
+ */
+uint8_t iso15693Inventory(rfid_tag_t *tags, const uint8_t maxTags)
+{
+  inventory_mask_t pending[MAX_PENDING_MASKS];
+  inventory_mask_t mask;
+  uint8_t pendingCount = 0;
+  uint8_t count = 0;
+  uint16_t rounds = 0;
+
+  if ((rfidProtocol() != MFRC630_PROTO_ISO15693) && !rfidLoadProtocol(MFRC630_PROTO_ISO15693))
+    return 0;
+
+  // Start with an empty mask
+  memset(&mask, 0, sizeof(mask));
+
+  while (count < maxTags) {
+    mask.collided = inventoryRound(&mask, tags, &count, maxTags);
+    rounds++;
+
+    if (mask.collided != 0)
+      pending[pendingCount++] = mask;
+
+    // Next collided slot of the deepest level that has one left
+    while ((pendingCount > 0) && (pending[pendingCount - 1].collided == 0))
+      pendingCount--;
+    if (pendingCount == 0)
+      break;
+
+    inventory_mask_t *parent = &pending[pendingCount - 1];
+    uint8_t slot = 0;
+
+    while (!(parent->collided & (1 << slot)))
+      slot++;
+    parent->collided &= ~(1 << slot);
+
+    mask = *parent;
+    mask.mask[mask.bits / 8] |= slot << (mask.bits % 8);
+    mask.bits += 4;
+  }
+
+  emberAfCorePrintln("iso15693: found %d tag(s) in %d round(s)", count, rounds);
+  return count;
+
+}
+
+/** @brief Read multiple blocks from a tag
+ *  @param tag Tag from iso15693Inventory
+ *  @param firstBlock First block
+ *  @param count Number of blocks
+ *  @param buffer Buffer for the block data
+ *  @param len Size of buffer
+ *  @return Number of bytes read, or -1 on error
+ */
+int16_t iso15693ReadBlocks(const rfid_tag_t *tag, const uint8_t firstBlock, const uint8_t count, uint8_t *buffer, const uint16_t len)
+{
+  uint8_t req[4 + ISO15693_UID_SIZE] = { ISO15693_FLAG_DATA_RATE | ISO15693_FLAG_ADDRESS,
+                                         ISO15693_CMD_READ_MULTIPLE_BLOCKS };
+  uint8_t resp[RFID_FIFO_SIZE];
+  uint16_t dataLen = count * ISO15693_BLOCK_SIZE;
+
+  if ((count == 0) || (dataLen > len) || (dataLen + 1 > sizeof(resp)))
+    return -1;
+
+  memcpy(&req[2], tag->rfid, ISO15693_UID_SIZE);
+  req[2 + ISO15693_UID_SIZE] = firstBlock;
+  req[3 + ISO15693_UID_SIZE] = count - 1;
+
+  int16_t res = rfidTransceive(req, sizeof(req), resp, dataLen + 1, ISO15693_TIMEOUT(dataLen + 1));
+
+  if ((res != dataLen + 1) || (resp[0] & ISO15693_FLAG_ERROR))
+    return -1;
+
+  memcpy(buffer, &resp[1], dataLen);
+  return dataLen;
+
+}
@@ -0,0 +1,40 @@
+/*
+ * iso15693.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef ISO15693_H_
+#define ISO15693_H_
+
+#include "app/framework/include/af.h"
+
+#include "rfid.h"
+
+#define ISO15693_UID_SIZE         8
+#define ISO15693_SLOTS            16
+#define ISO15693_BLOCK_SIZE       4           /**< ICODE SLIX block size */
+
+/*! ISO15693 request flags */
+enum iso15693_flags {
+  ISO15693_FLAG_DATA_RATE = (1 << 1),         /**< High data rate */
+  ISO15693_FLAG_INVENTORY = (1 << 2),         /**< Inventory request */
+  ISO15693_FLAG_ADDRESS = (1 << 5),           /**< Addressed (non-inventory) */
+  ISO15693_FLAG_ONE_SLOT = (1 << 5),          /**< 1 slot instead of 16 (inventory) */
+  ISO15693_FLAG_ERROR = (1 << 0)              /**< Error (response) */
+};
+
+/*! ISO15693 commands */
+enum iso15693_cmd {
+  ISO15693_CMD_INVENTORY = 0x01,
+  ISO15693_CMD_STAY_QUIET = 0x02,
+  ISO15693_CMD_READ_BLOCK = 0x20,
+  ISO15693_CMD_READ_MULTIPLE_BLOCKS = 0x23,
+  ISO15693_CMD_GET_SYSTEM_INFO = 0x2B
+};
+
+uint8_t iso15693Inventory(rfid_tag_t *tags, uint8_t maxTags);
+int16_t iso15693ReadBlocks(const rfid_tag_t *tag, uint8_t firstBlock, uint8_t count, uint8_t *buffer, uint16_t len);
+
+#endif /* ISO15693_H_ */
@@ -0,0 +1,145 @@
+/*
+ * isodep.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "isodep.h"
+
+/* RATS parameter; FSDI 7 (128 byte frames, the FIFO holds 255), CID 0 */
+#define RATS_PARAM                0x70
+
+/* Default FWI if the ATS has no TB(1) */
+#define DEFAULT_FWI               4
+
+/* Frame size for the card; FSCI to bytes (ISO14443-4 Table 1) */
+static const uint16_t fscTable[] = { 16, 24, 32, 40, 48, 64, 96, 128, 256 };
+
+static uint8_t blockNumber = 0;
+static uint16_t frameWaitTime = RFID_DEFAULT_TIMEOUT;   // T0 ticks
+static uint16_t cardFrameSize = 16;
+
+/** @brief Activate ISO14443-4 (RATS) on a selected card
+ *  @return true if the card answered with a valid ATS
+ */
+bool isodepActivate(void)
+{
+  uint8_t rats[2] = { ISODEP_CMD_RATS, RATS_PARAM };
+  uint8_t ats[32];
+  uint8_t fwi = DEFAULT_FWI;
+
+  int16_t len = rfidTransceive(rats, sizeof(rats), ats, sizeof(ats), RFID_DEFAULT_TIMEOUT);
+
+  if ((len < 1) || (ats[0] != len)) {
+    emberAfCorePrintln("ERROR: no ATS");
+    return false;
+  }
+
+  cardFrameSize = 32;
+
+  if (len > 1) {
+    uint8_t t0 = ats[1];
+    uint8_t i = 2;
+
+    if ((t0 & 0x0F) < sizeof(fscTable) / sizeof(fscTable[0]))
+      cardFrameSize = fscTable[t0 & 0x0F];
+
+    // Skip TA(1); TB(1) holds FWI in the upper nibble
+    if (t0 & 0x10)
+      i++;
+    if ((t0 & 0x20) && (i < len))
+      fwi = ats[i] >> 4;
+  }
+
+  // FWT = 302 us * 2^FWI; one T0 tick is 4.72 us
+  uint32_t ticks = 64UL << fwi;
+  frameWaitTime = (ticks > 0xFFFF) ? 0xFFFF : (uint16_t)ticks;
+
+  blockNumber = 0;
+
+  emberAfCorePrintln("isodep: fsc = %d, fwi = %d", cardFrameSize, fwi);
+  return true;
+
+}
+
+/** @brief Send an APDU/native command and receive the response
+ *  @param txbuf Command (INF field)
+ *  @param txlen Length of command
+ *  @param rxbuf Buffer for the response (INF field)
+ *  @param rxlen Size of response buffer
+ *  @return Length of the response, or -1 on error
+ *  @note Handles waiting time extensions and chained responses
+ */
+int16_t isodepTransceive(uint8_t *txbuf, const uint8_t txlen, uint8_t *rxbuf, const uint16_t rxlen)
+{
+  uint8_t frame[RFID_FIFO_SIZE];
+  uint16_t total = 0;
+  uint16_t timeout = frameWaitTime;
+  uint8_t flen;
+
+  // Command must fit in one frame (PCB + INF + CRC)
+  if (txlen + 3 > cardFrameSize)
+    return -1;
+
+  frame[0] = ISODEP_PCB_I_BLOCK | blockNumber;
+  memcpy(&frame[1], txbuf, txlen);
+  flen = txlen + 1;
+
+  while (true) {
+    int16_t len = rfidTransceive(frame, flen, frame, sizeof(frame), timeout);
+
+    if (len < 1)
+      return -1;
+
+    uint8_t pcb = frame[0];
+
+    // Waiting time extension; echo it back and wait FWT * WTXM for the next frame only
+    if ((pcb & 0xF7) == ISODEP_PCB_S_WTX) {
+      if (len < 2)
+        return -1;
+
+      uint8_t wtxm = frame[1] & ISODEP_WTXM_MASK;
+      if ((wtxm == 0) || (wtxm > ISODEP_WTXM_MAX))
+        return -1;
+
+      uint32_t ticks = (uint32_t)frameWaitTime * wtxm;
+      timeout = (ticks > 0xFFFF) ? 0xFFFF : (uint16_t)ticks;
+      flen = len;
+      continue;
+    }
+
+    timeout = frameWaitTime;
+
+    if ((pcb & 0xE2) != ISODEP_PCB_I_BLOCK)
+      return -1;
+
+    blockNumber ^= 1;
+
+    if (total + len - 1 > rxlen)
+      return -1;
+
+    memcpy(&rxbuf[total], &frame[1], len - 1);
+    total += len - 1;
+
+    if (!(pcb & ISODEP_PCB_CHAINING))
+      break;
+
+    // Ask for the next part of a chained response
+    frame[0] = ISODEP_PCB_R_ACK | blockNumber;
+    flen = 1;
+  }
+
+  return total;
+
+}
+
+/** @brief Deselect the card (S(DESELECT))
+ */
+void isodepDeselect(void)
+{
+  uint8_t pcb = ISODEP_PCB_S_DESELECT;
+  uint8_t resp;
+
+  rfidTransceive(&pcb, 1, &resp, 1, frameWaitTime);
+}
@@ -0,0 +1,36 @@
+/*
+ * isodep.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef ISODEP_H_
+#define ISODEP_H_
+
+#include "app/framework/include/af.h"
+
+#include "rfid.h"
+
+/*! SAK bit set by cards compliant with ISO14443-4 */
+#define ISODEP_SAK_COMPLIANT      (1 << 5)
+
+/*! WTXM field of an S(WTX) request (ISO14443-4 7.3) */
+#define ISODEP_WTXM_MASK          0x3F
+#define ISODEP_WTXM_MAX           59
+
+/*! ISO14443-4 block types and commands */
+enum isodep_cmd {
+  ISODEP_CMD_RATS = 0xE0,                 /**< Request for answer to select */
+  ISODEP_PCB_I_BLOCK = 0x02,              /**< I-block (bit 0 = block number) */
+  ISODEP_PCB_R_ACK = 0xA2,                /**< R(ACK) block */
+  ISODEP_PCB_S_DESELECT = 0xC2,           /**< S(DESELECT) block */
+  ISODEP_PCB_S_WTX = 0xF2,                /**< S(WTX) block */
+  ISODEP_PCB_CHAINING = 0x10              /**< More data follows */
+};
+
+bool isodepActivate(void);
+int16_t isodepTransceive(uint8_t *txbuf, uint8_t txlen, uint8_t *rxbuf, uint16_t rxlen);
+void isodepDeselect(void);
+
+#endif /* ISODEP_H_ */
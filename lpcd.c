@@ -0,0 +1,575 @@
+/*
+ * lpcd.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "lpcd.h"
+
+#include "duty.h"
+#include "energy.h"
+#include "report.h"
+#include "rfid_config.h"
+
+#include "sl_sleeptimer.h"
+
+#define TUNE_PERIOD_MS            ((uint32_t)RFID_LPCD_TUNE_PERIOD * 1000UL)
+
+#if (RFID_LPCD_TUNE_PERIOD > 0) && (RFID_LPCD_CONFIRM_MS == 0)
+#error "LPCD threshold tuning needs RFID_LPCD_CONFIRM_MS > 0"
+#endif
+
+/* Registers written when LPCD is armed */
+static lpcd_params_t params = {
+  .qMin = 0,
+  .qMax = 0,
+  .iMin = 0,
+  .drvMod = LPCD_DRV_MOD,
+  .txAmp = 0,
+  .drvCon = 0,
+  .txl = 0,
+  .rxAna = LPCD_RX_ANA,
+  .t3Reload = LPCD_T3_RELOAD,
+  .t4Reload = 0,
+};
+static bool txSaved = false;                  /**< Transmitter setup after soft reset is in params */
+
+static uint32_t fullArms = 0;
+static uint32_t fastArms = 0;
+static uint32_t fullArmUs = 0;
+static uint32_t fastArmUs = 0;
+static uint32_t armFailures = 0;
+
+/* Baseline EWMA (Q8.8) and the centre of the current window */
+static uint16_t baselineI = 0;
+static uint16_t baselineQ = 0;
+static uint8_t windowI = 0;
+static uint8_t windowQ = 0;
+static bool calibrated = false;
+
+/* Detection window half-width, tuned towards RFID_LPCD_FALSE_WAKE_TARGET */
+static uint8_t threshold = RFID_LPCD_THRESHOLD;
+static uint32_t periodStart = 0;
+static uint32_t periodWakes = 0;
+static uint32_t widened = 0;
+static uint32_t narrowed = 0;
+
+/* I/Q result captured at the last LPCD interrupt */
+static uint8_t wakeI = 0;
+static uint8_t wakeQ = 0;
+
+/* Wakes without an ATQA, held back until no card has answered for RFID_LPCD_CONFIRM_MS */
+static uint32_t pendingStart = 0;
+static uint32_t pendingSumI = 0;
+static uint32_t pendingSumQ = 0;
+static uint16_t pendingCount = 0;
+
+static uint32_t falseWakes = 0;
+static uint32_t cardWakes = 0;
+static uint32_t discardedWakes = 0;
+static uint32_t rewindows = 0;
+
+/** @brief Clamp a window edge to the 6 bit result range
+ */
+static uint8_t clampResult(const int16_t value)
+{
+  if (value < 0)
+    return 0;
+  if (value > LPCD_RESULT_MAX)
+    return LPCD_RESULT_MAX;
+  return (uint8_t)value;
+}
+
+/** @brief Calculate the window register values around a baseline
+ *  @note IMax is split over bits 7..6 of the three registers
+ */
+static void windowRegisters(const uint8_t iVal, const uint8_t qVal, uint8_t *qMin, uint8_t *qMax, uint8_t *iMin)
+{
+  uint8_t bQMin = clampResult((int16_t)qVal - threshold);
+  uint8_t bQMax = clampResult((int16_t)qVal + threshold);
+  uint8_t bIMin = clampResult((int16_t)iVal - threshold);
+  uint8_t bIMax = clampResult((int16_t)iVal + threshold);
+
+  *qMin = bQMin | ((bIMax & 0b00110000) << 2);
+  *qMax = bQMax | ((bIMax & 0b00001100) << 4);
+  *iMin = bIMin | ((bIMax & 0b00000011) << 6);
+}
+
+/** @brief Store window and baseline so they survive a reset
+ */
+static void saveCalibration(void)
+{
+  tokTypeLpcdCalibration calibration;
+
+  calibration.magic = LPCD_CALIBRATION_MAGIC;
+  calibration.qMin = params.qMin;
+  calibration.qMax = params.qMax;
+  calibration.iMin = params.iMin;
+  calibration.windowI = windowI;
+  calibration.windowQ = windowQ;
+  calibration.threshold = threshold;
+  calibration.baselineI = baselineI;
+  calibration.baselineQ = baselineQ;
+  halCommonSetToken(TOKEN_LPCD_CALIBRATION, &calibration);
+}
+
+/** @brief Set the window registers around a baseline
+ *  @param iVal I baseline
+ *  @param qVal Q baseline
+ *  @note The new window is persisted in the LPCD_CALIBRATION token
+ */
+void lpcdSetWindow(const uint8_t iVal, const uint8_t qVal)
+{
+  windowRegisters(iVal, qVal, &params.qMin, &params.qMax, &params.iMin);
+  windowI = iVal;
+  windowQ = qVal;
+  calibrated = true;
+  saveCalibration();
+
+  emberAfCorePrintln("LPCD window: i = %d, q = %d, threshold = %d (LPCD_QMin = %d, LPCD_QMax = %d, LPCD_IMin = %d)",
+                     iVal, qVal, threshold, params.qMin, params.qMax, params.iMin);
+}
+
+/** @brief Restore window and baseline from the LPCD_CALIBRATION token
+ *  @return true if a valid calibration was restored and trimming can be skipped
+ *  @note The stored registers must match the ones recalculated from the
+ *        stored window centre and threshold, and the threshold must be
+ *        within the configured limits
+ */
+bool lpcdRestore(void)
+{
+  tokTypeLpcdCalibration calibration;
+  uint8_t qMin, qMax, iMin;
+
+  halCommonGetToken(&calibration, TOKEN_LPCD_CALIBRATION);
+
+  if ((calibration.magic != LPCD_CALIBRATION_MAGIC)
+      || (calibration.threshold < RFID_LPCD_THRESHOLD_MIN) || (calibration.threshold > RFID_LPCD_THRESHOLD_MAX)
+      || (calibration.windowI > LPCD_RESULT_MAX) || (calibration.windowQ > LPCD_RESULT_MAX)
+      || (calibration.baselineI > (LPCD_RESULT_MAX << LPCD_FRACTION_BITS))
+      || (calibration.baselineQ > (LPCD_RESULT_MAX << LPCD_FRACTION_BITS))) {
+    emberAfCorePrintln("LPCD calibration: none stored");
+    return false;
+  }
+
+  threshold = calibration.threshold;
+  windowRegisters(calibration.windowI, calibration.windowQ, &qMin, &qMax, &iMin);
+  if ((qMin != calibration.qMin) || (qMax != calibration.qMax) || (iMin != calibration.iMin)) {
+    emberAfCorePrintln("LPCD calibration: stored window is inconsistent");
+    threshold = RFID_LPCD_THRESHOLD;
+    return false;
+  }
+
+  params.qMin = qMin;
+  params.qMax = qMax;
+  params.iMin = iMin;
+  windowI = calibration.windowI;
+  windowQ = calibration.windowQ;
+  baselineI = calibration.baselineI;
+  baselineQ = calibration.baselineQ;
+  calibrated = true;
+  periodStart = halCommonGetInt32uMillisecondTick();
+
+  emberAfCorePrintln("LPCD calibration restored: i = %d, q = %d, threshold = %d (LPCD_QMin = %d, LPCD_QMax = %d, LPCD_IMin = %d)",
+                     windowI, windowQ, threshold, params.qMin, params.qMax, params.iMin);
+  return true;
+}
+
+/** @brief Drop the current calibration
+ *  @note The next lpcdInit runs the trimming procedure and calculates
+ *        a new window
+ */
+void lpcdRecalibrate(void)
+{
+  tokTypeLpcdCalibration calibration;
+
+  memset(&calibration, 0, sizeof(calibration));
+  calibrated = false;
+  baselineI = 0;
+  baselineQ = 0;
+  threshold = RFID_LPCD_THRESHOLD;
+  halCommonSetToken(TOKEN_LPCD_CALIBRATION, &calibration);
+}
+
+/** @brief Current detection window half-width
+ *  @return Threshold in ADC counts
+ */
+uint8_t lpcdThreshold(void)
+{
+  return threshold;
+}
+
+/** @brief Check if a window is known
+ *  @return true if the window registers hold a calibrated or restored window
+ */
+bool lpcdCalibrated(void)
+{
+  return calibrated;
+}
+
+/** @brief Start baseline tracking from a calibration sample
+ */
+void lpcdBaselineInit(const uint8_t iVal, const uint8_t qVal)
+{
+  baselineI = (uint16_t)iVal << LPCD_FRACTION_BITS;
+  baselineQ = (uint16_t)qVal << LPCD_FRACTION_BITS;
+  periodStart = halCommonGetInt32uMillisecondTick();
+  periodWakes = 0;
+  lpcdSetWindow(iVal, qVal);
+}
+
+/** @brief Run the trimming procedure and centre a new window on the result
+ *  @note Expects the reader right after a soft reset
+ */
+static void calibrate(void)
+{
+  // Open window while trimming
+  write8(MFRC630_REG_LPCD_QMIN, 0xc0);
+  write8(MFRC630_REG_LPCD_QMAX, 0xff);
+  write8(MFRC630_REG_LPCD_IMIN, 0xc0);
+  write8(MFRC630_REG_DRV_MOD, params.drvMod);
+
+  // Execute trimming procedure
+  write8(MFRC630_REG_T3_RELOAD_HI, 0x00);   // Write default T3 reload value Hi
+  write8(MFRC630_REG_T3_RELOAD_LO, 0x10);   // Write default T3 reload value Lo
+  write8(MFRC630_REG_T4_RELOAD_HI, 0x00);   // Write min. T4 reload value Hi
+  write8(MFRC630_REG_T4_RELOAD_LO, 0x05);   // Write min. T4 reload value Lo
+  write8(MFRC630_REG_T4_CONTROL, 0xf8);     // Config T4 for AutoLPCD & AutoRestart. Set AutoTrimm bit. Start T4.
+  write8(MFRC630_REG_LPCD_Q_RESULT, 0x40);  // Clear LPCD result
+  write8(MFRC630_REG_RCV, 0x52);            // Set Rx_ADCmode bit
+  write8(MFRC630_REG_RX_ANA, params.rxAna); // Raise receiver gain to maximum
+  write8(MFRC630_REG_COMMAND, 0x01);        // Execute Rc663 command "Auto_T4" (Low power card detection and/or Auto trimming)
+
+  // Flush CMD and FIFO
+  write8(MFRC630_REG_COMMAND, 0x00);
+  write8(MFRC630_REG_FIFO_CONTROL, 0xb0);
+
+  // Clear Rx_ADCmode bit
+  write8(MFRC630_REG_RCV, 0x12);
+
+  // The baseline is tracked from here on
+  lpcdBaselineInit(read8(MFRC630_REG_LPCD_I_RESULT) & LPCD_RESULT_MASK,
+                   read8(MFRC630_REG_LPCD_Q_RESULT) & LPCD_RESULT_MASK);
+}
+
+/** @brief Write params to the reader and start low power card detection
+ *  @return false if T4 did not start within LPCD_T4_START_TIMEOUT ms
+ */
+static bool arm(void)
+{
+  params.t4Reload = dutyPowerDownMs() * DUTY_T4_TICKS_PER_MS - 1;
+
+  // Transmitter and window
+  write8(MFRC630_REG_DRV_MOD, params.drvMod);
+  write8(MFRC630_REG_TX_AMP, params.txAmp);
+  write8(MFRC630_REG_DRV_CON, params.drvCon);
+  write8(MFRC630_REG_TXL, params.txl);
+  write8(MFRC630_REG_LPCD_QMIN, params.qMin);
+  write8(MFRC630_REG_LPCD_QMAX, params.qMax);
+  write8(MFRC630_REG_LPCD_IMIN, params.iMin);
+
+  // Detection and power down time
+  write8(MFRC630_REG_T3_RELOAD_HI, params.t3Reload >> 8);
+  write8(MFRC630_REG_T3_RELOAD_LO, params.t3Reload & 0xFF);
+  write8(MFRC630_REG_T4_RELOAD_HI, params.t4Reload >> 8);
+  write8(MFRC630_REG_T4_RELOAD_LO, params.t4Reload & 0xFF);
+  write8(MFRC630_REG_T4_CONTROL, LPCD_T4_START);
+
+  // Clear LPCD result, set Rx_ADCmode bit, receiver gain
+  write8(MFRC630_REG_LPCD_Q_RESULT, 0x40);
+  write8(MFRC630_REG_RCV, 0x52);
+  write8(MFRC630_REG_RX_ANA, params.rxAna);
+
+  // Wait until T4 is started
+  uint32_t start = halCommonGetInt32uMillisecondTick();
+  while (read8(MFRC630_REG_T4_CONTROL) != LPCD_T4_RUNNING) {
+    if (halCommonGetInt32uMillisecondTick() - start > LPCD_T4_START_TIMEOUT) {
+      emberAfCorePrintln("LPCD: T4 did not start");
+      armFailures++;
+      return false;
+    }
+  }
+
+  // Flush cmd and FIFO. Clear all IRQ flags.
+  writeCommand(MFRC630_CMD_IDLE);
+  write8(MFRC630_REG_FIFO_CONTROL, 0xb0);
+  write8(MFRC630_REG_IRQ0, 0x7f);
+  write8(MFRC630_REG_IRQ1, 0x7f);
+
+  // Enable IRQ sources: Idle and LPCD
+  write8(MFRC630_REG_IRQ0EN, 0x10);
+  write8(MFRC630_REG_IRQ1EN, 0x60);
+
+  // Start RC663 cmd "Low power card detection". Enter PowerDown mode.
+  writeCommand(MFRC630_CMD_LPCD);
+  energyLpcdArmed((params.t4Reload + 1) / DUTY_T4_TICKS_PER_MS);
+  return true;
+}
+
+/** @brief Time since a sleeptimer tick count
+ *  @note The millisecond tick is too coarse for a re-arm, which is a few
+ *        ms of register writes
+ */
+static uint32_t elapsedUs(const uint32_t startTick)
+{
+  return (uint32_t)(((uint64_t)(sl_sleeptimer_get_tick_count() - startTick) * 1000000UL) / sl_sleeptimer_get_timer_frequency());
+}
+
+/** @brief Soft reset the reader, calibrate if no window is known and arm LPCD
+ *  @return true if LPCD was armed
+ *  @note Used at startup, after a recalibration request and when a fast
+ *        re-arm fails
+ */
+bool lpcdInit(void)
+{
+  uint32_t start = sl_sleeptimer_get_tick_count();
+
+  energyPhaseBegin(ENERGY_PHASE_LPCD_ARM);
+  rfidSoftReset();
+
+  params.txAmp = read8(MFRC630_REG_TX_AMP);
+  params.drvCon = read8(MFRC630_REG_DRV_CON);
+  params.txl = read8(MFRC630_REG_TXL);
+  txSaved = true;
+
+  if (!calibrated)
+    calibrate();
+
+  bool armed = arm();
+  energyPhaseEnd(ENERGY_PHASE_LPCD_ARM);
+
+  fullArms++;
+  fullArmUs = elapsedUs(start);
+  return armed;
+}
+
+/** @brief Arm LPCD again after a tag event
+ *  @return true if LPCD was armed
+ *  @note Only the transmitter, window, timer and IRQ registers are written;
+ *        no soft reset and no trimming. Falls back to lpcdInit if the
+ *        reader has not been set up yet or T4 does not start.
+ */
+bool lpcdRearm(void)
+{
+  if (!txSaved || !calibrated)
+    return lpcdInit();
+
+  uint32_t start = sl_sleeptimer_get_tick_count();
+
+  // Stop whatever the reader was doing for the last exchange
+  energyPhaseBegin(ENERGY_PHASE_LPCD_ARM);
+  writeCommand(MFRC630_CMD_IDLE);
+
+  bool armed = arm();
+  energyPhaseEnd(ENERGY_PHASE_LPCD_ARM);
+  if (!armed)
+    return lpcdInit();
+
+  fastArms++;
+  fastArmUs = elapsedUs(start);
+  return true;
+}
+
+/** @brief Keep the I/Q result that triggered an LPCD interrupt
+ *  @note Must be called before the reader is set up for reading
+ */
+void lpcdCapture(void)
+{
+  wakeI = read8(MFRC630_REG_LPCD_I_RESULT) & LPCD_RESULT_MASK;
+  wakeQ = read8(MFRC630_REG_LPCD_Q_RESULT) & LPCD_RESULT_MASK;
+}
+
+/** @brief Absolute difference of two results
+ */
+static uint8_t distance(const uint8_t a, const uint8_t b)
+{
+  return (a > b) ? a - b : b - a;
+}
+
+/** @brief Update one EWMA: avg += (sample - avg) / 2^RFID_LPCD_EWMA_SHIFT
+ */
+static uint16_t ewma(const uint16_t avg, const uint8_t sample)
+{
+  int32_t diff = ((int32_t)sample << LPCD_FRACTION_BITS) - avg;
+  return (uint16_t)(avg + diff / (1 << RFID_LPCD_EWMA_SHIFT));
+}
+
+/** @brief Rounded integer part of a Q8.8 value
+ */
+static uint8_t toResult(const uint16_t value)
+{
+  return (uint8_t)((value + (1 << (LPCD_FRACTION_BITS - 1))) >> LPCD_FRACTION_BITS);
+}
+
+#if RFID_LPCD_TUNE_PERIOD > 0
+#if RFID_LPCD_FALSE_WAKE_TARGET > 0
+/** @brief Narrow the window by up to steps, not below RFID_LPCD_THRESHOLD_MIN
+ */
+static void narrowThreshold(const uint32_t steps)
+{
+  if (threshold <= RFID_LPCD_THRESHOLD_MIN)
+    return;
+
+  uint32_t room = threshold - RFID_LPCD_THRESHOLD_MIN;
+  uint32_t n = (steps < room) ? steps : room;
+
+  threshold -= (uint8_t)n;
+  narrowed += n;
+}
+#endif
+
+/** @brief Count a confirmed false wake burst against RFID_LPCD_FALSE_WAKE_TARGET per period
+ *  @return true if the threshold changed
+ *  @note The window is widened as soon as a period exceeds the target and
+ *        narrowed by one step for each period that ended below half of it,
+ *        including periods without any wake at all
+ */
+static bool tuneThreshold(void)
+{
+  uint8_t previous = threshold;
+  uint32_t now = halCommonGetInt32uMillisecondTick();
+  uint32_t elapsed = now - periodStart;
+
+  // Close the periods that ended before this wake
+  if (elapsed >= TUNE_PERIOD_MS) {
+#if RFID_LPCD_FALSE_WAKE_TARGET > 0
+    if (periodWakes * 2 < RFID_LPCD_FALSE_WAKE_TARGET)
+      narrowThreshold(1);
+
+    // The rest of them had no false wake at all
+    narrowThreshold(elapsed / TUNE_PERIOD_MS - 1);
+#endif
+
+    periodWakes = 0;
+    periodStart = now - (elapsed % TUNE_PERIOD_MS);
+  }
+
+  periodWakes++;
+
+  if ((periodWakes > RFID_LPCD_FALSE_WAKE_TARGET) && (threshold < RFID_LPCD_THRESHOLD_MAX)) {
+    threshold++;
+    widened++;
+    periodWakes = 0;
+    periodStart = now;
+  }
+
+  if (threshold == previous)
+    return false;
+
+  emberAfCorePrintln("LPCD threshold %d -> %d", previous, threshold);
+  reportLpcdThreshold(threshold, falseWakes);
+  return true;
+}
+#else
+static bool tuneThreshold(void)
+{
+  return false;
+}
+#endif
+
+/** @brief Feed the held back wakes into the baseline and the false wake rate
+ *  @return true if the window was moved (baseline drifted more than
+ *          RFID_LPCD_DRIFT_MAX from the window centre) or resized
+ *  @note Only params change; they are written on the next LPCD re-arm,
+ *        no extra soft reset or trimming is needed
+ */
+static bool confirmFalseWakes(void)
+{
+  uint8_t sampleI = (uint8_t)((pendingSumI + pendingCount / 2) / pendingCount);
+  uint8_t sampleQ = (uint8_t)((pendingSumQ + pendingCount / 2) / pendingCount);
+
+  // A burst of wakes is one disturbance for the tuning
+  bool retuned = tuneThreshold();
+
+  // Their mean stands in for the individual samples
+  for (uint16_t n = 0; n < pendingCount; n++) {
+    baselineI = ewma(baselineI, sampleI);
+    baselineQ = ewma(baselineQ, sampleQ);
+  }
+
+  falseWakes += pendingCount;
+  pendingCount = 0;
+  pendingSumI = 0;
+  pendingSumQ = 0;
+
+  uint8_t i = toResult(baselineI);
+  uint8_t q = toResult(baselineQ);
+
+  if ((distance(i, windowI) <= RFID_LPCD_DRIFT_MAX) && (distance(q, windowQ) <= RFID_LPCD_DRIFT_MAX)) {
+    if (!retuned)
+      return false;
+
+    // Keep the centre, only the width changes
+    i = windowI;
+    q = windowQ;
+  } else {
+    rewindows++;
+  }
+
+  lpcdSetWindow(i, q);
+  return true;
+
+}
+
+/** @brief A wake got no ATQA; hold its captured I/Q back as a possible false wake
+ *  @return true if earlier wakes were confirmed and moved or resized the window
+ *  @note A card that is still approaching wakes LPCD before it can answer.
+ *        Its wakes are dropped by lpcdCardWake if a card answers within
+ *        RFID_LPCD_CONFIRM_MS; only the rest reach the baseline and the
+ *        threshold tuning, when the next wake comes in.
+ */
+bool lpcdFalseWake(void)
+{
+  uint32_t now = halCommonGetInt32uMillisecondTick();
+  bool moved = false;
+
+  if (!calibrated) {
+    falseWakes++;
+    return false;
+  }
+
+  if ((pendingCount > 0) && (now - pendingStart >= RFID_LPCD_CONFIRM_MS))
+    moved = confirmFalseWakes();
+
+  if (pendingCount == 0)
+    pendingStart = now;
+
+  if (pendingCount < UINT16_MAX) {
+    pendingSumI += wakeI;
+    pendingSumQ += wakeQ;
+    pendingCount++;
+  }
+
+  if (RFID_LPCD_CONFIRM_MS == 0)
+    moved |= confirmFalseWakes();
+
+  return moved;
+}
+
+/** @brief A wake was answered by a card; drop the held back wakes
+ *  @note They were most likely the same card approaching
+ */
+void lpcdCardWake(void)
+{
+  cardWakes++;
+  discardedWakes += pendingCount;
+  pendingCount = 0;
+  pendingSumI = 0;
+  pendingSumQ = 0;
+}
+
+/** @brief Print baseline and false wake counters
+ */
+void lpcdPrintStats(void)
+{
+  emberAfCorePrintln("lpcd: baseline i = %d/256, q = %d/256, window i = %d, q = %d, last wake i = %d, q = %d",
+                     baselineI, baselineQ, windowI, windowQ, wakeI, wakeQ);
+  emberAfCorePrintln("lpcd: %d full arms (last %d us), %d fast re-arms (last %d us), %d T4 start failures",
+                     fullArms, fullArmUs, fastArms, fastArmUs, armFailures);
+  emberAfCorePrintln("lpcd: %d false wakes (%d pending), %d card wakes, %d wakes dropped as approaching cards, %d re-windows",
+                     falseWakes, pendingCount, cardWakes, discardedWakes, rewindows);
+  emberAfCorePrintln("lpcd: threshold = %d (%d..%d), %d false wake bursts this period (target %d per %d s), %d widened, %d narrowed",
+                     threshold, RFID_LPCD_THRESHOLD_MIN, RFID_LPCD_THRESHOLD_MAX, periodWakes,
+                     RFID_LPCD_FALSE_WAKE_TARGET, RFID_LPCD_TUNE_PERIOD, widened, narrowed);
+}
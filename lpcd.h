@@ -0,0 +1,58 @@
+/*
+ * lpcd.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef LPCD_H_
+#define LPCD_H_
+
+#include "app/framework/include/af.h"
+
+#include "rfid.h"
+
+/*! LPCD I and Q results are 6 bit values */
+#define LPCD_RESULT_MASK          0x3F
+#define LPCD_RESULT_MAX           LPCD_RESULT_MASK
+
+/*! Baseline is kept as a Q8.8 fixed-point EWMA */
+#define LPCD_FRACTION_BITS        8
+
+/*! Register values while LPCD is armed */
+#define LPCD_DRV_MOD              0x89        /**< Drivers for the detection field */
+#define LPCD_RX_ANA               0x03        /**< Receiver gain at maximum */
+#define LPCD_T3_RELOAD            0x07F2      /**< Detection time 150 us */
+#define LPCD_T4_START             0xDF        /**< AutoLPCD, AutoRestart, AutoWakeUp, 2 kHz LFO, start */
+#define LPCD_T4_RUNNING           0x9F        /**< T4Control read back once T4 runs */
+#define LPCD_T4_START_TIMEOUT     5           /**< ms */
+
+/*! Everything written to the reader to arm LPCD */
+typedef struct {
+  uint8_t qMin;                               /**< LPCD_QMIN incl. IMax bits 5..4 */
+  uint8_t qMax;                               /**< LPCD_QMAX incl. IMax bits 3..2 */
+  uint8_t iMin;                               /**< LPCD_IMIN incl. IMax bits 1..0 */
+  uint8_t drvMod;
+  uint8_t txAmp;                              /**< Transmitter setup as after a soft reset; */
+  uint8_t drvCon;                             /**< restored on a fast re-arm since reading */
+  uint8_t txl;                                /**< a tag loads the protocol values */
+  uint8_t rxAna;
+  uint16_t t3Reload;                          /**< Detection time */
+  uint16_t t4Reload;                          /**< Power-down time (2 kHz LFO ticks) */
+} lpcd_params_t;
+
+bool lpcdInit(void);
+bool lpcdRearm(void);
+
+void lpcdBaselineInit(uint8_t iVal, uint8_t qVal);
+void lpcdSetWindow(uint8_t iVal, uint8_t qVal);
+bool lpcdRestore(void);
+void lpcdRecalibrate(void);
+bool lpcdCalibrated(void);
+uint8_t lpcdThreshold(void);
+void lpcdCapture(void);
+bool lpcdFalseWake(void);
+void lpcdCardWake(void);
+void lpcdPrintStats(void);
+
+#endif /* LPCD_H_ */
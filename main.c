@@ -40,10 +40,23 @@
 #include "gpiointerrupt.h"
 
 #include "rfid.h"
-
-// 5V control
-#define ENABLE_5V_PORT          gpioPortD
-#define ENABLE_5V_PIN           3
+#include "rfid_cli.h"
+#include "poll.h"
+#include "rfid_crypto.h"
+#include "rfid_config.h"
+#include "report.h"
+#include "sun.h"
+#include "originality.h"
+#include "tagtype.h"
+#include "presence.h"
+#include "dedup.h"
+#include "cache.h"
+#include "lpcd.h"
+#include "duty.h"
+#include "energy.h"
+#include "field.h"
+#include "tune.h"
+#include "encode.h"
 
 // I2C
 #define I2C_PORT                gpioPortC
@@ -62,6 +75,10 @@ bool handlingTag = false;
 bool okToSleep = true;
 bool rfidIrq = false;
 
+static sl_zigbee_event_t presenceEvent;
+static sl_zigbee_event_t dutyEvent;
+static bool presenceReported = false;
+
 /** @brief Handle RFID interrupt
  *  @param pin GPIO pin
  *  @note Triggered by LPCD (low power card detect; i.e. a card has been detected)
@@ -70,7 +87,9 @@ bool rfidIrq = false;
 void rfid_irq_handler(uint8_t intNo)
 {
   GPIO_ExtIntConfig(RFID_INT_PORT, RFID_INT_PIN, RFID_IRQ_NO, false, false, false);
+#if RFID_DEBUG_IRQ
   emberAfCorePrintln("rfid irq: intNo = %d", intNo);
+#endif
   rfidIrq = (intNo == RFID_IRQ_NO);
 }
 
@@ -83,7 +102,7 @@ static void initGpio(void)
   GPIO_DbgSWDIOEnable(false);
 
   // Configure 5V control
-  GPIO_PinModeSet(ENABLE_5V_PORT, ENABLE_5V_PIN, gpioModePushPull, 0);
+  fieldInit();
 
   // Enable GPIO interrupts
   GPIOINT_Init();
@@ -207,23 +226,25 @@ static void printRfidVersion(void)
 
 }
 
-static void readTag(rfid_tag_t* rfid_tag, const uint8_t maxAttempts)
+static bool readTag(rfid_tag_t* rfid_tag, const uint8_t maxAttempts)
 {
-  // Read interrupt registers
-  uint8_t regVal0 = read8(MFRC630_REG_IRQ0);
-  uint8_t regVal1 = read8(MFRC630_REG_IRQ1);
-  emberAfCorePrintln("Before read: MFRC630_REG_IRQ0 = 0x%x, MFRC630_REG_IRQ1 = 0x%x", regVal0, regVal1);
+  bool found = false;
+
+#if RFID_DEBUG_IRQ
+  emberAfCorePrintln("Before read: MFRC630_REG_IRQ0 = 0x%x, MFRC630_REG_IRQ1 = 0x%x", read8(MFRC630_REG_IRQ0), read8(MFRC630_REG_IRQ1));
+#endif
 
   // Read tag
   for (int i = 0; i < maxAttempts; i++) {
-    if (readRfidTag(rfid_tag)) {
+    if (pollTag(rfid_tag)) {
       emberAfCorePrintln("===================================");
-      emberAfCorePrintln("read tag, size = %d, sak = %d", rfid_tag->size, rfid_tag->sak);
+      emberAfCorePrintln("read tag, protocol = 0x%x, size = %d, sak = %d", rfid_tag->protocol, rfid_tag->size, rfid_tag->sak);
       emberAfCorePrint("tag:");
       for (int i = 0; i < rfid_tag->size; i++)
         emberAfCorePrint(" %x", rfid_tag->rfid[i]);
       emberAfCorePrintln("");
       emberAfCorePrintln("===================================");
+      found = true;
       break;
     }
     else {
@@ -233,38 +254,147 @@ static void readTag(rfid_tag_t* rfid_tag, const uint8_t maxAttempts)
     }
   }
 
-  // Read interrupt registers
-  regVal0 = read8(MFRC630_REG_IRQ0);
-  regVal1 = read8(MFRC630_REG_IRQ1);
-  emberAfCorePrintln("After read: MFRC630_REG_IRQ0 = 0x%x, MFRC630_REG_IRQ1 = 0x%x", regVal0, regVal1);
+#if RFID_DEBUG_IRQ
+  emberAfCorePrintln("After read: MFRC630_REG_IRQ0 = 0x%x, MFRC630_REG_IRQ1 = 0x%x", read8(MFRC630_REG_IRQ0), read8(MFRC630_REG_IRQ1));
+#endif
+
+  return found;
+
+}
+
+/** @brief Re-arm LPCD and the RFID interrupt after handling a tag
+ */
+static void rearmLpcd(void)
+{
+  lpcdRearm();
+  handlingTag = false;
+  rfidIrq = false;
+  GPIO_ExtIntConfig(RFID_INT_PORT, RFID_INT_PIN, RFID_IRQ_NO, true, false, true);
+  okToSleep = true;
+
+  // Wake up again when the power-down period is due to change
+  uint32_t next = dutyNextChangeMs();
+  if (next > 0)
+    sl_zigbee_event_set_delay_ms(&dutyEvent, next);
+  else
+    sl_zigbee_event_set_inactive(&dutyEvent);
+}
 
+/** @brief Re-arm an idle LPCD with the current power-down period
+ *  @note Skipped while a tag is handled or tracked; those paths re-arm
+ *        themselves when done
+ */
+static void dutyEventHandler(sl_zigbee_event_t *event)
+{
+  sl_zigbee_event_set_inactive(event);
+
+  if (handlingTag || rfidIrq || sl_zigbee_event_is_scheduled(&presenceEvent))
+    return;
+
+  if (dutyChanged())
+    rearmLpcd();
+  else if (dutyNextChangeMs() > 0)
+    sl_zigbee_event_set_delay_ms(event, dutyNextChangeMs());
+}
+
+/** @brief Probe the tracked tag; re-arm LPCD once it has left
+ */
+static void presenceEventHandler(sl_zigbee_event_t *event)
+{
+  sl_zigbee_event_set_inactive(event);
+
+  fieldBegin();
+  presence_event_t state = presenceProbe();
+  fieldEnd();
+
+  if (state == PRESENCE_PRESENT) {
+    sl_zigbee_event_set_delay_ms(event, RFID_PRESENCE_INTERVAL);
+    return;
+  }
+
+  emberAfCorePrintln("tag departed");
+  if (presenceReported)
+    reportDeparture(presenceTag());
+  rearmLpcd();
 }
 
 static void handleTag(void)
 {
   rfid_tag_t rfid_tag;
+  bool report = false;
+  bool tracked = false;
+
+  fieldBegin();
 
-  // Initialize RFID
-  rfidInit();
+  // One WUPA first; without an answer go straight back to LPCD
+  if (!pollProbe()) {
+    fieldEnd();
+    lpcdFalseWake();
+    rearmLpcd();
+    return;
+  }
+
+  // A card answered (or could not be ruled out); earlier wakes were likely it approaching
+  lpcdCardWake();
+
+  // Try to read tag; check result (the poll loop sets up the protocol)
+  if (readTag(&rfid_tag, 3)) {
+    emberAfCorePrintln("tag arrived");
+    dutyActivity();
+    energyTap();
+    if (encodeActive()) {
+      // Bench encoding; nothing is reported
+      encodeTag(&rfid_tag);
+      presenceReported = false;
+    }
+    else if (dedupIsRepeat(&rfid_tag))
+      presenceReported = false;
+    else {
+      presenceReported = tagTypeProcess(&rfid_tag);
+      report = presenceReported;
+      if (!presenceReported)
+        emberAfCorePrintln("tag not verified; not reported");
+    }
+
+    // Watch for departure with WUPA probes instead of reading it again on every LPCD wakeup
+    tracked = presenceStart(&rfid_tag);
+  }
 
-  // Try to read tag; check result
-  readTag(&rfid_tag, 3);
+  // Last exchange done; the field is not needed while reporting
+  emberAfCorePrintln("field on %d ms", fieldEnd());
 
-  halCommonDelayMilliseconds(100);
+  if (report)
+    reportTag(&rfid_tag);
+
+  if (tracked) {
+    sl_zigbee_event_set_delay_ms(&presenceEvent, RFID_PRESENCE_INTERVAL);
+    handlingTag = false;
+    rfidIrq = false;
+    okToSleep = true;
+    return;
+  }
 
   // Reset
-  rfidLpcdInit();
-  handlingTag = false;
-  rfidIrq = false;
-  GPIO_ExtIntConfig(RFID_INT_PORT, RFID_INT_PIN, RFID_IRQ_NO, true, false, true);
-  okToSleep = true;
+  rearmLpcd();
 
 }
 
 void app_init(void)
 {
+  energyInit();
   initGpio();
   initI2C();
+  rfidCliInit();
+  rfidCryptoInit();
+  sunInit();
+#if RFID_ORIGINALITY_CHECK
+  originalityInit();
+#endif
+  dedupInit();
+  cacheInit();
+  pollInit();
+  sl_zigbee_event_init(&presenceEvent, presenceEventHandler);
+  sl_zigbee_event_init(&dutyEvent, dutyEventHandler);
 
   // Print reset cause
   emberAfCorePrintln("Reset info: 0x%x (%p)", halGetResetInfo(), halGetResetString());
@@ -279,8 +409,14 @@ void app_init(void)
   // Print RFID version
   printRfidVersion();
 
-  // Enter LPCD mode
-  rfidLpcdInit();
+  // Antenna profile from the tuning sweep, if any
+  tuneRestore();
+
+  // Reuse the stored LPCD window; trimming only runs without one
+  lpcdRestore();
+
+  // Enter LPCD mode (the first re-arm runs the full setup)
+  rearmLpcd();
 
 }
 
@@ -290,28 +426,28 @@ void app_process_action(void)
 
     okToSleep = false;
 
-    printQIValues();
+    lpcdCapture();
 
     // Get Irq1 status
     uint8_t regVal = read8(MFRC630_REG_IRQ1);
 
+#if RFID_DEBUG_IRQ
     emberAfCorePrintln("MFRC630_REG_IRQ1 == 0x%x", regVal);
+#endif
 
     // Check if LPCD irq is triggered
     if ((regVal & 0x20) != 0) {
 
-      emberAfCorePrintln("lpcd irq");
-
-      emberAfCorePrintln("Flush any running command and FIFO");
+      // Flush any running command and FIFO
       write8(MFRC630_REG_COMMAND, 0x00);
       write8(MFRC630_REG_IRQ0EN, 0x00);
       write8(MFRC630_REG_IRQ1EN, 0x00);
 
       write8(MFRC630_REG_FIFO_CONTROL, 0xb0);
 
-      // Read error status register
-      uint8_t errorStatus = read8(MFRC630_REG_ERROR);
-      emberAfCorePrintln("error status register = 0x%x", errorStatus);
+#if RFID_DEBUG_IRQ
+      emberAfCorePrintln("error status register = 0x%x", read8(MFRC630_REG_ERROR));
+#endif
 
       // Clear Rx_ADCmode bit
       write8(MFRC630_REG_RCV, 0x12);
@@ -327,7 +463,7 @@ void app_process_action(void)
     }
 
     else {
-      rfidLpcdInit();
+      lpcdInit();
       rfidIrq = false;
       GPIO_ExtIntConfig(RFID_INT_PORT, RFID_INT_PIN, RFID_IRQ_NO, true, false, true);
       okToSleep = true;
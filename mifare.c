@@ -0,0 +1,382 @@
+/*
+ * mifare.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "mifare.h"
+
+/* Max. time for EEPROM key commands and authentication */
+#define MIFARE_KEY_TIMEOUT        10          // ms
+#define MIFARE_AUTH_TIMEOUT       10          // ms
+
+/* READ response (16 bytes) */
+#define MIFARE_READ_TIMEOUT       (RFID_DEFAULT_TIMEOUT + MIFARE_BLOCK_SIZE * 20)
+
+/* WRITE and TRANSFER ACK after the EEPROM write (max. 10 ms) */
+#define MIFARE_WRITE_TIMEOUT      2120
+
+/* INCREMENT/DECREMENT operand is not answered; a NAK comes within ~1 ms */
+#define MIFARE_OPERAND_TIMEOUT    250
+
+/* Field off time that resets the card to IDLE before re-selecting it */
+#define MIFARE_RESELECT_OFF_MS    5
+
+/* Step latency targets for a value operation within one tap (ms) */
+#define MIFARE_AUTH_TARGET        5
+#define MIFARE_READ_TARGET        3
+#define MIFARE_OPERATION_TARGET   15
+#define MIFARE_VERIFY_TARGET      3
+
+/** @brief Store a key in the reader EEPROM (STOREKEYE2)
+ *  @param keyNo Key number (0..MIFARE_EEPROM_KEYS-1)
+ *  @param key 6 byte key
+ *  @return true if stored
+ *  @note Meant for provisioning; keys stay in the reader and are not sent
+ *        over I2C when reading cards
+ */
+bool mifareStoreKey(const uint8_t keyNo, const uint8_t *key)
+{
+  uint8_t params[1 + MIFARE_KEY_SIZE];
+
+  if (keyNo >= MIFARE_EEPROM_KEYS)
+    return false;
+
+  params[0] = keyNo;
+  memcpy(&params[1], key, MIFARE_KEY_SIZE);
+
+  return rfidCommand(MFRC630_CMD_STOREKEYE2, sizeof(params), params, MIFARE_KEY_TIMEOUT);
+}
+
+/** @brief Load a key from the reader EEPROM into the key buffer (LOADKEYE2)
+ *  @param keyNo Key number (0..MIFARE_EEPROM_KEYS-1)
+ *  @return true if loaded
+ */
+bool mifareLoadKey(uint8_t keyNo)
+{
+  if (keyNo >= MIFARE_EEPROM_KEYS)
+    return false;
+
+  return rfidCommand(MFRC630_CMD_LOADKEYE2, 1, &keyNo, MIFARE_KEY_TIMEOUT);
+}
+
+/** @brief Authenticate a sector with the key in the key buffer (MFAUTHENT)
+ *  @param keyType MIFARE_CMD_AUTH_A or MIFARE_CMD_AUTH_B
+ *  @param block Any block in the sector
+ *  @param uid UID of the selected card
+ *  @param uidLen Length of UID; the last 4 bytes are used
+ *  @return true if the crypto engine is on after authentication
+ */
+bool mifareAuth(const uint8_t keyType, const uint8_t block, const uint8_t *uid, const uint8_t uidLen)
+{
+  uint8_t params[6] = { keyType, block };
+
+  if (uidLen < 4)
+    return false;
+
+  // Double size UIDs authenticate with the cascade level 2 bytes
+  memcpy(&params[2], &uid[uidLen - 4], 4);
+
+  /* Configure the frame wait timeout using T0. */
+  write8(MFRC630_REG_T0_CONTROL, 0b10001);
+  write8(MFRC630_REG_T0_RELOAD_HI, RFID_DEFAULT_TIMEOUT >> 8);
+  write8(MFRC630_REG_TO_RELOAD_LO, 0xFF);
+  write8(MFRC630_REG_T0_COUNTER_VAL_HI, RFID_DEFAULT_TIMEOUT >> 8);
+  write8(MFRC630_REG_T0_COUNTER_VAL_LO, 0xFF);
+
+  rfidCommand(MFRC630_CMD_MFAUTHENT, sizeof(params), params, MIFARE_AUTH_TIMEOUT);
+
+  if (!mifareIsAuthenticated()) {
+    emberAfCorePrintln("ERROR: authentication failed (block %d)", block);
+    return false;
+  }
+
+  return true;
+
+}
+
+/** @brief Check if the MIFARE Classic crypto engine is on
+ */
+bool mifareIsAuthenticated(void)
+{
+  return (read8(MFRC630_REG_STATUS) & MFRC630STATUS_CRYPTO1ON) != 0;
+}
+
+/** @brief Switch off the crypto engine
+ */
+void mifareDeauth(void)
+{
+  uint8_t status = read8(MFRC630_REG_STATUS);
+  write8(MFRC630_REG_STATUS, status & ~MFRC630STATUS_CRYPTO1ON);
+}
+
+/** @brief Reset and re-select the card for a new plain authentication
+ *  @param uid UID of the card
+ *  @param uidLen Length of UID
+ *  @return true if the same card was selected again
+ *  @note After mifareDeauth the card still holds its Crypto1 session and
+ *        ignores a plain MFAUTHENT; switching the field off resets it
+ */
+bool mifareReselect(const uint8_t *uid, const uint8_t uidLen)
+{
+  uint8_t id[10];
+  uint8_t sak;
+
+  mifareDeauth();
+  rfidFieldOff();
+  halCommonDelayMilliseconds(MIFARE_RESELECT_OFF_MS);
+  rfidInit();
+
+  if (iso14443aCommand(ISO14443_CMD_WUPA) == 0)
+    return false;
+
+  return (iso14443aSelect(id, &sak) == uidLen) && (memcmp(id, uid, uidLen) == 0);
+}
+
+/** @brief Read a block from an authenticated sector
+ *  @param block Block number
+ *  @param buffer Buffer for 16 bytes
+ *  @return Number of bytes read, or -1 on error
+ */
+int16_t mifareReadBlock(const uint8_t block, uint8_t *buffer)
+{
+  uint8_t cmd[2] = { MIFARE_CMD_READ, block };
+  return rfidTransceive(cmd, 2, buffer, MIFARE_BLOCK_SIZE, MIFARE_READ_TIMEOUT);
+}
+
+/** @brief Write a block in an authenticated sector (two step WRITE)
+ *  @param block Block number
+ *  @param data 16 bytes
+ *  @return true if both steps were acknowledged
+ */
+bool mifareWriteBlock(const uint8_t block, const uint8_t *data)
+{
+  uint8_t cmd[2] = { MIFARE_CMD_WRITE, block };
+  uint8_t buffer[MIFARE_BLOCK_SIZE];
+
+  if (!rfidTransceiveAck(cmd, 2, RFID_DEFAULT_TIMEOUT))
+    return false;
+
+  memcpy(buffer, data, MIFARE_BLOCK_SIZE);
+  return rfidTransceiveAck(buffer, MIFARE_BLOCK_SIZE, MIFARE_WRITE_TIMEOUT);
+}
+
+/** @brief Format a value block
+ *  @param value Value
+ *  @param address Address byte (free for the application; usually the block number)
+ *  @param block Buffer for 16 bytes
+ */
+void mifareEncodeValue(const int32_t value, const uint8_t address, uint8_t *block)
+{
+  uint32_t v = (uint32_t)value;
+
+  for (uint8_t i = 0; i < 4; i++) {
+    block[i] = (uint8_t)(v >> (8 * i));
+    block[4 + i] = (uint8_t)~block[i];
+    block[8 + i] = block[i];
+  }
+
+  block[12] = address;
+  block[13] = (uint8_t)~address;
+  block[14] = address;
+  block[15] = (uint8_t)~address;
+}
+
+/** @brief Decode and check a value block
+ *  @param block 16 bytes
+ *  @param value Value on return
+ *  @param address Address byte on return (may be NULL)
+ *  @return true if the block is a valid value block
+ */
+bool mifareDecodeValue(const uint8_t *block, int32_t *value, uint8_t *address)
+{
+  for (uint8_t i = 0; i < 4; i++) {
+    if ((block[i] != block[8 + i]) || ((block[i] ^ block[4 + i]) != 0xFF))
+      return false;
+  }
+
+  if ((block[12] != block[14]) || (block[13] != block[15]) || ((block[12] ^ block[13]) != 0xFF))
+    return false;
+
+  *value = (int32_t)((uint32_t)block[0] | ((uint32_t)block[1] << 8) | ((uint32_t)block[2] << 16) | ((uint32_t)block[3] << 24));
+  if (address != NULL)
+    *address = block[12];
+
+  return true;
+}
+
+/** @brief Send INCREMENT/DECREMENT to the card's transfer buffer
+ *  @return true if accepted
+ *  @note The operand is not acknowledged; only a NAK is sent back
+ */
+static bool valueCommand(const uint8_t cmd, const uint8_t block, const int32_t amount)
+{
+  uint8_t request[2] = { cmd, block };
+  uint8_t operand[4];
+  uint8_t resp;
+  uint8_t error;
+
+  if (!rfidTransceiveAck(request, 2, RFID_DEFAULT_TIMEOUT))
+    return false;
+
+  for (uint8_t i = 0; i < 4; i++)
+    operand[i] = (uint8_t)((uint32_t)amount >> (8 * i));
+
+  return (rfidExchange(operand, 4, &resp, 1, MIFARE_OPERAND_TIMEOUT, &error) < 0) && (error == 0);
+}
+
+/** @brief Store the transfer buffer in a block
+ */
+static bool transfer(const uint8_t block)
+{
+  uint8_t cmd[2] = { MIFARE_CMD_TRANSFER, block };
+  return rfidTransceiveAck(cmd, 2, MIFARE_WRITE_TIMEOUT);
+}
+
+/** @brief Record a step time and warn if it is over its target
+ */
+static uint16_t stepTime(const char *step, uint32_t *start, const uint16_t target)
+{
+  uint32_t now = halCommonGetInt32uMillisecondTick();
+  uint16_t ms = (uint16_t)(now - *start);
+
+  if (ms > target)
+    emberAfCorePrintln("value: %s took %d ms (target %d ms)", step, ms, target);
+
+  *start = now;
+  return ms;
+}
+
+/** @brief Read, increment or decrement, transfer and verify a value block
+ *  @param block Value block
+ *  @param op MIFARE_VALUE_INCREMENT or MIFARE_VALUE_DECREMENT
+ *  @param amount Amount (> 0)
+ *  @param keyType MIFARE_CMD_AUTH_A or MIFARE_CMD_AUTH_B
+ *  @param keyNo Number of the key in the reader EEPROM
+ *  @param uid UID of the selected card
+ *  @param uidLen Length of UID
+ *  @param value New value on return (old value if the operation was refused)
+ *  @param timing Step times on return (may be NULL)
+ *  @return true if the new value was read back
+ *  @note Everything runs under one authentication. A decrement below 0 is
+ *        refused before anything is written. The block only changes on
+ *        TRANSFER, so an interrupted operation leaves the old value.
+ */
+bool mifareValueOperation(const uint8_t block, const mifare_value_op_t op, const int32_t amount,
+                          const uint8_t keyType, const uint8_t keyNo,
+                          const uint8_t *uid, const uint8_t uidLen,
+                          int32_t *value, mifare_value_timing_t *timing)
+{
+  mifare_value_timing_t t = { 0 };
+  uint8_t data[MIFARE_BLOCK_SIZE];
+  uint32_t start = halCommonGetInt32uMillisecondTick();
+  int32_t expected;
+  bool ok = false;
+
+  if (amount <= 0)
+    return false;
+
+  if (!mifareLoadKey(keyNo) || !mifareAuth(keyType, block, uid, uidLen))
+    return false;
+  t.auth = stepTime("auth", &start, MIFARE_AUTH_TARGET);
+
+  if ((mifareReadBlock(block, data) != MIFARE_BLOCK_SIZE) || !mifareDecodeValue(data, value, NULL)) {
+    emberAfCorePrintln("ERROR: block %d is not a value block", block);
+    goto exit;
+  }
+  t.read = stepTime("read", &start, MIFARE_READ_TARGET);
+
+  if (op == MIFARE_VALUE_DECREMENT) {
+    if (*value < amount) {
+      emberAfCorePrintln("ERROR: value %d < %d", *value, amount);
+      goto exit;
+    }
+    expected = *value - amount;
+  }
+  else {
+    if (*value > INT32_MAX - amount)
+      goto exit;
+    expected = *value + amount;
+  }
+
+  if (!valueCommand((uint8_t)op, block, amount) || !transfer(block)) {
+    emberAfCorePrintln("ERROR: value operation failed (block %d)", block);
+    goto exit;
+  }
+  t.operation = stepTime("operation", &start, MIFARE_OPERATION_TARGET);
+
+  if ((mifareReadBlock(block, data) != MIFARE_BLOCK_SIZE) || !mifareDecodeValue(data, value, NULL)
+      || (*value != expected)) {
+    emberAfCorePrintln("ERROR: value not verified (block %d)", block);
+    goto exit;
+  }
+  t.verify = stepTime("verify", &start, MIFARE_VERIFY_TARGET);
+  ok = true;
+
+exit:
+  mifareDeauth();
+
+  if (timing != NULL)
+    *timing = t;
+
+  return ok;
+
+}
+
+/** @brief First block of a sector (Classic 1K/4K layout)
+ */
+uint8_t mifareSectorFirstBlock(const uint8_t sector)
+{
+  return (sector < 32) ? sector * 4 : 128 + (sector - 32) * 16;
+}
+
+/** @brief Number of blocks in a sector (Classic 1K/4K layout)
+ */
+uint8_t mifareSectorBlocks(const uint8_t sector)
+{
+  return (sector < 32) ? 4 : 16;
+}
+
+/** @brief Read all blocks of a sector with a single authentication
+ *  @param sector Sector number
+ *  @param keyType MIFARE_CMD_AUTH_A or MIFARE_CMD_AUTH_B
+ *  @param keyNo Number of the key in the reader EEPROM
+ *  @param uid UID of the selected card
+ *  @param uidLen Length of UID
+ *  @param buffer Buffer for the sector data (incl. sector trailer)
+ *  @param len Size of buffer
+ *  @return Number of bytes read, or -1 on error
+ */
+int16_t mifareReadSector(const uint8_t sector, const uint8_t keyType, const uint8_t keyNo,
+                         const uint8_t *uid, const uint8_t uidLen,
+                         uint8_t *buffer, const uint16_t len)
+{
+  uint8_t first = mifareSectorFirstBlock(sector);
+  uint8_t blocks = mifareSectorBlocks(sector);
+  int16_t total = 0;
+
+  if ((sector >= 40) || (len < blocks * MIFARE_BLOCK_SIZE))
+    return -1;
+
+  if (!mifareLoadKey(keyNo))
+    return -1;
+
+  if (!mifareAuth(keyType, first, uid, uidLen))
+    return -1;
+
+  // One authentication covers every block in the sector
+  for (uint8_t i = 0; i < blocks; i++) {
+    if (!mifareIsAuthenticated() || (mifareReadBlock(first + i, &buffer[total]) != MIFARE_BLOCK_SIZE)) {
+      emberAfCorePrintln("ERROR: failed to read block %d", first + i);
+      total = -1;
+      break;
+    }
+    total += MIFARE_BLOCK_SIZE;
+  }
+
+  mifareDeauth();
+
+  return total;
+
+}
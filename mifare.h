@@ -0,0 +1,57 @@
+/*
+ * mifare.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef MIFARE_H_
+#define MIFARE_H_
+
+#include "app/framework/include/af.h"
+
+#include "rfid.h"
+
+#define MIFARE_BLOCK_SIZE         16
+#define MIFARE_KEY_SIZE           6
+
+/*! Number of keys that fit in the CLRC663 key area of the EEPROM */
+#define MIFARE_EEPROM_KEYS        128
+
+/*! Value block operations */
+typedef enum {
+  MIFARE_VALUE_INCREMENT = MIFARE_CMD_INCREMENT,
+  MIFARE_VALUE_DECREMENT = MIFARE_CMD_DECREMENT
+} mifare_value_op_t;
+
+/*! Time of each step of a value block operation (ms) */
+typedef struct {
+  uint16_t auth;
+  uint16_t read;
+  uint16_t operation;                         /**< INCREMENT/DECREMENT + TRANSFER */
+  uint16_t verify;
+} mifare_value_timing_t;
+
+bool mifareStoreKey(uint8_t keyNo, const uint8_t *key);
+bool mifareLoadKey(uint8_t keyNo);
+bool mifareAuth(uint8_t keyType, uint8_t block, const uint8_t *uid, uint8_t uidLen);
+bool mifareIsAuthenticated(void);
+void mifareDeauth(void);
+bool mifareReselect(const uint8_t *uid, uint8_t uidLen);
+int16_t mifareReadBlock(uint8_t block, uint8_t *buffer);
+bool mifareWriteBlock(uint8_t block, const uint8_t *data);
+
+void mifareEncodeValue(int32_t value, uint8_t address, uint8_t *block);
+bool mifareDecodeValue(const uint8_t *block, int32_t *value, uint8_t *address);
+bool mifareValueOperation(uint8_t block, mifare_value_op_t op, int32_t amount,
+                          uint8_t keyType, uint8_t keyNo,
+                          const uint8_t *uid, uint8_t uidLen,
+                          int32_t *value, mifare_value_timing_t *timing);
+
+uint8_t mifareSectorFirstBlock(uint8_t sector);
+uint8_t mifareSectorBlocks(uint8_t sector);
+int16_t mifareReadSector(uint8_t sector, uint8_t keyType, uint8_t keyNo,
+                         const uint8_t *uid, uint8_t uidLen,
+                         uint8_t *buffer, uint16_t len);
+
+#endif /* MIFARE_H_ */
@@ -0,0 +1,217 @@
+/*
+ * ndef.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "ndef.h"
+
+/** @brief Make sure a byte range of tag memory is in the reader window
+ *  @param reader NDEF reader
+ *  @param offset Tag byte offset
+ *  @param len Number of bytes needed
+ *  @return Pointer into the window, or NULL if the range can't be read
+ *  @note Only reads from the tag if the range is not already in the window.
+ *        The window is refilled from the page holding offset, so a record
+ *        that did not fit in the previous window ends up at its start.
+ */
+static const uint8_t *ndefSpan(ndef_reader_t *reader, const uint16_t offset, const uint16_t len)
+{
+  if ((offset >= reader->windowStart) && (offset + len <= reader->windowStart + reader->windowLength))
+    return &reader->window[offset - reader->windowStart];
+
+  uint16_t page = offset / NTAG_PAGE_SIZE;
+  uint16_t pages = NDEF_WINDOW_PAGES;
+
+  // Range must fit in the window once aligned to a page
+  if ((offset % NTAG_PAGE_SIZE) + len > NDEF_WINDOW_SIZE)
+    return NULL;
+
+  if (page >= reader->info->pages)
+    return NULL;
+
+  if (page + pages > reader->info->pages)
+    pages = reader->info->pages - page;
+
+  int16_t res = ntagReadPages(reader->info, (uint8_t)page, (uint8_t)pages, reader->window);
+  reader->reads++;
+
+  if (res <= 0) {
+    reader->windowLength = 0;
+    return NULL;
+  }
+
+  reader->windowStart = page * NTAG_PAGE_SIZE;
+  reader->windowLength = res;
+
+  if (offset + len > reader->windowStart + reader->windowLength)
+    return NULL;
+
+  return &reader->window[offset - reader->windowStart];
+
+}
+
+/** @brief Find the NDEF message TLV
+ *  @param reader NDEF reader
+ *  @param start On return; tag byte offset of the message
+ *  @param length On return; length of the message
+ *  @return true if an NDEF message TLV was found
+ */
+static bool ndefFindMessage(ndef_reader_t *reader, uint16_t *start, uint16_t *length)
+{
+  uint16_t offset = NTAG_USER_START_PAGE * NTAG_PAGE_SIZE;
+  const uint8_t *p;
+
+  while ((p = ndefSpan(reader, offset, 1)) != NULL) {
+    uint8_t type = p[0];
+    uint16_t len;
+
+    offset++;
+
+    if (type == NDEF_TLV_NULL)
+      continue;
+
+    if (type == NDEF_TLV_TERMINATOR)
+      return false;
+
+    // Length; 1 byte, or 0xFF followed by 2 bytes
+    if ((p = ndefSpan(reader, offset, 1)) == NULL)
+      return false;
+
+    if (p[0] == 0xFF) {
+      if ((p = ndefSpan(reader, offset + 1, 2)) == NULL)
+        return false;
+      len = (p[0] << 8) | p[1];
+      offset += 3;
+    }
+    else {
+      len = p[0];
+      offset += 1;
+    }
+
+    if (type == NDEF_TLV_NDEF_MESSAGE) {
+      *start = offset;
+      *length = len;
+      return true;
+    }
+
+    // Skip lock control, memory control and proprietary TLVs
+    offset += len;
+  }
+
+  return false;
+
+}
+
+/** @brief Initialize NDEF reader
+ *  @param reader NDEF reader
+ *  @param info Tag info from ntagGetVersion
+ */
+void ndefReaderInit(ndef_reader_t *reader, const ntag_info_t *info)
+{
+  reader->info = info;
+  reader->windowStart = 0;
+  reader->windowLength = 0;
+  reader->reads = 0;
+}
+
+/** @brief Find the first NDEF record matching type and/or ID
+ *  @param reader NDEF reader
+ *  @param type Record type to match, or NULL for any type
+ *  @param typeLength Length of type
+ *  @param id Record ID to match, or NULL for any ID
+ *  @param idLength Length of id
+ *  @param record On return; the record (pointers into the reader window)
+ *  @return true if a matching record was found
+ *  @note Parsing stops at the first match, so only the pages up to and
+ *        including that record are read from the tag
+ */
+bool ndefFindRecord(ndef_reader_t *reader,
+                    const uint8_t *type, const uint8_t typeLength,
+                    const uint8_t *id, const uint8_t idLength,
+                    ndef_record_t *record)
+{
+  uint16_t offset, msgLength;
+
+  if (!ndefFindMessage(reader, &offset, &msgLength))
+    return false;
+
+  uint16_t msgEnd = offset + msgLength;
+
+  while (offset < msgEnd) {
+    const uint8_t *p;
+    uint8_t flags, typeLen, idLen = 0;
+    uint32_t payloadLen;
+    uint16_t hdrLen;
+
+    // Fixed part of the header: flags, type length, payload length
+    if ((p = ndefSpan(reader, offset, 3)) == NULL)
+      return false;
+
+    flags = p[0];
+    typeLen = p[1];
+
+    if (flags & NDEF_FLAG_SR) {
+      payloadLen = p[2];
+      hdrLen = 3;
+    }
+    else {
+      if ((p = ndefSpan(reader, offset, 6)) == NULL)
+        return false;
+      payloadLen = ((uint32_t)p[2] << 24) | ((uint32_t)p[3] << 16) | (p[4] << 8) | p[5];
+      hdrLen = 6;
+    }
+
+    if (flags & NDEF_FLAG_IL) {
+      if ((p = ndefSpan(reader, offset + hdrLen, 1)) == NULL)
+        return false;
+      idLen = p[0];
+      hdrLen++;
+    }
+
+    uint32_t recordLen = hdrLen + typeLen + idLen + payloadLen;
+
+    if (offset + recordLen > msgEnd)
+      return false;
+
+    // Match type and ID before pulling in the payload
+    bool match = !(flags & NDEF_FLAG_CF);
+
+    if (match && (type != NULL || id != NULL)) {
+      if ((p = ndefSpan(reader, offset + hdrLen, typeLen + idLen)) == NULL)
+        return false;
+      if ((type != NULL) && ((typeLen != typeLength) || memcmp(p, type, typeLen)))
+        match = false;
+      if ((id != NULL) && ((idLen != idLength) || memcmp(&p[typeLen], id, idLen)))
+        match = false;
+    }
+
+    if (match) {
+      // Whole record in the window, then decode in place
+      if ((p = ndefSpan(reader, offset, (uint16_t)recordLen)) == NULL) {
+        emberAfCorePrintln("ndef: record too big (%d bytes)", recordLen);
+        return false;
+      }
+
+      record->tnf = flags & NDEF_TNF_MASK;
+      record->typeLength = typeLen;
+      record->type = &p[hdrLen];
+      record->idLength = idLen;
+      record->id = &p[hdrLen + typeLen];
+      record->payloadLength = (uint16_t)payloadLen;
+      record->payload = &p[hdrLen + typeLen + idLen];
+
+      emberAfCorePrintln("ndef: found record after %d read(s)", reader->reads);
+      return true;
+    }
+
+    if (flags & NDEF_FLAG_ME)
+      break;
+
+    offset += recordLen;
+  }
+
+  return false;
+
+}
@@ -0,0 +1,65 @@
+/*
+ * ndef.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef NDEF_H_
+#define NDEF_H_
+
+#include "app/framework/include/af.h"
+
+#include "ntag.h"
+
+/*! Pages fetched per read; a badge record normally fits in the first window */
+#define NDEF_WINDOW_PAGES         16
+#define NDEF_WINDOW_SIZE          (NDEF_WINDOW_PAGES * NTAG_PAGE_SIZE)
+
+/*! TLV block types (NFC Forum Type 2 Tag) */
+enum ndef_tlv {
+  NDEF_TLV_NULL = 0x00,
+  NDEF_TLV_LOCK_CONTROL = 0x01,
+  NDEF_TLV_MEMORY_CONTROL = 0x02,
+  NDEF_TLV_NDEF_MESSAGE = 0x03,
+  NDEF_TLV_PROPRIETARY = 0xFD,
+  NDEF_TLV_TERMINATOR = 0xFE
+};
+
+/*! NDEF record header flags */
+enum ndef_flags {
+  NDEF_FLAG_MB = (1 << 7),                    /**< Message begin */
+  NDEF_FLAG_ME = (1 << 6),                    /**< Message end */
+  NDEF_FLAG_CF = (1 << 5),                    /**< Chunked record */
+  NDEF_FLAG_SR = (1 << 4),                    /**< Short record (1 byte payload length) */
+  NDEF_FLAG_IL = (1 << 3),                    /**< ID length present */
+  NDEF_TNF_MASK = 0x07                        /**< Type name format */
+};
+
+/*! Streaming reader; pages are pulled from the tag on demand */
+typedef struct {
+  const ntag_info_t *info;
+  uint8_t window[NDEF_WINDOW_SIZE];           /**< Tag memory as drained from the FIFO */
+  uint16_t windowStart;                       /**< Tag byte offset of window[0] */
+  uint16_t windowLength;                      /**< Valid bytes in window */
+  uint8_t reads;                              /**< Number of tag reads done */
+} ndef_reader_t;
+
+/*! Decoded record; all pointers point into the reader window */
+typedef struct {
+  uint8_t tnf;
+  const uint8_t *type;
+  uint8_t typeLength;
+  const uint8_t *id;
+  uint8_t idLength;
+  const uint8_t *payload;
+  uint16_t payloadLength;
+} ndef_record_t;
+
+void ndefReaderInit(ndef_reader_t *reader, const ntag_info_t *info);
+bool ndefFindRecord(ndef_reader_t *reader,
+                    const uint8_t *type, uint8_t typeLength,
+                    const uint8_t *id, uint8_t idLength,
+                    ndef_record_t *record);
+
+#endif /* NDEF_H_ */
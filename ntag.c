@@ -0,0 +1,231 @@
+/*
+ * ntag.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "ntag.h"
+
+/* Response time is roughly 85 us (18 T0 ticks) per byte at 106 kbit/s */
+#define NTAG_TIMEOUT(bytes)       (RFID_DEFAULT_TIMEOUT + (bytes) * 20)
+
+/* Pages of original Ultralight (no GET_VERSION support) */
+#define ULTRALIGHT_PAGES          16
+
+/* Max. EEPROM write time is 4.1 ms; allow 10 ms */
+#define NTAG_WRITE_TIMEOUT        2120
+
+/* Static lock bytes are bytes 2 and 3 of page 2 */
+#define NTAG_STATIC_LOCK_PAGE     2
+
+/* Dynamic lock bytes and config pages follow the user memory */
+#define NTAG_DYNAMIC_LOCK_OFFSET  5           // Pages before the end of memory
+#define NTAG_CONFIG_PAGES         4
+
+/** @brief Map GET_VERSION storage size byte to number of pages
+ *  @param storageSize Byte 6 of the GET_VERSION response
+ *  @return Total number of pages, or 0 if unknown
+ */
+static uint8_t storageSizeToPages(const uint8_t storageSize)
+{
+  switch (storageSize) {
+    case 0x0B:
+      return 20;                              // Ultralight EV1 (MF0UL11), NTAG210
+    case 0x0E:
+      return 41;                              // Ultralight EV1 (MF0UL21), NTAG212
+    case 0x0F:
+      return 45;                              // NTAG213
+    case 0x11:
+      return 135;                             // NTAG215
+    case 0x13:
+      return 231;                             // NTAG216
+    default:
+      return 0;
+  }
+}
+
+/** @brief Detect tag memory size with GET_VERSION
+ *  @param info Tag info; filled in on return
+ *  @return true if the tag answered GET_VERSION
+ *  @note A tag that does not support GET_VERSION (original Ultralight) NAKs
+ *        and returns to IDLE; it has to be selected again before use. The info
+ *        is then set up for a plain 16 page Ultralight using READ.
+ */
+bool ntagGetVersion(ntag_info_t *info)
+{
+  uint8_t cmd = NTAG_CMD_GET_VERSION;
+
+  memset(info, 0, sizeof(ntag_info_t));
+
+  if (rfidTransceive(&cmd, 1, info->version, sizeof(info->version), NTAG_TIMEOUT(sizeof(info->version))) != sizeof(info->version)) {
+    info->pages = ULTRALIGHT_PAGES;
+    info->fastRead = false;
+    return false;
+  }
+
+  info->pages = storageSizeToPages(info->version[6]);
+  info->fastRead = true;
+
+  if (info->pages == 0) {
+    emberAfCorePrintln("unknown storage size 0x%x", info->version[6]);
+    info->pages = ULTRALIGHT_PAGES;
+  }
+
+  emberAfCorePrintln("ntag: type 0x%x, subtype 0x%x, pages = %d", info->version[2], info->version[3], info->pages);
+  return true;
+
+}
+
+/** @brief Read 4 pages (16 bytes) with READ
+ *  @param page First page
+ *  @param buffer Buffer for the 16 bytes
+ *  @return Number of bytes read, or -1 on error
+ */
+int16_t ntagReadPage(const uint8_t page, uint8_t *buffer)
+{
+  uint8_t cmd[2] = { NTAG_CMD_READ, page };
+  return rfidTransceive(cmd, 2, buffer, NTAG_READ_PAGES * NTAG_PAGE_SIZE, NTAG_TIMEOUT(NTAG_READ_PAGES * NTAG_PAGE_SIZE));
+}
+
+/** @brief Read a page range with FAST_READ
+ *  @param startPage First page
+ *  @param endPage Last page (inclusive)
+ *  @param buffer Buffer for (endPage - startPage + 1) * 4 bytes
+ *  @return Number of bytes read, or -1 on error
+ *  @note The range must fit in the FIFO (NTAG_FAST_READ_MAX_PAGES)
+ */
+int16_t ntagFastRead(const uint8_t startPage, const uint8_t endPage, uint8_t *buffer)
+{
+  if ((endPage < startPage) || (endPage - startPage + 1 > NTAG_FAST_READ_MAX_PAGES))
+    return -1;
+
+  uint8_t cmd[3] = { NTAG_CMD_FAST_READ, startPage, endPage };
+  uint16_t len = (endPage - startPage + 1) * NTAG_PAGE_SIZE;
+
+  return rfidTransceive(cmd, 3, buffer, len, NTAG_TIMEOUT(len));
+}
+
+/** @brief Read an arbitrary page range
+ *  @param info Tag info from ntagGetVersion
+ *  @param startPage First page
+ *  @param count Number of pages
+ *  @param buffer Buffer for count * 4 bytes
+ *  @return Number of bytes read, or -1 on error
+ *  @note Uses as few FAST_READ exchanges as the FIFO allows, or READ if the
+ *        tag does not support FAST_READ
+ */
+int16_t ntagReadPages(const ntag_info_t *info, const uint8_t startPage, const uint8_t count, uint8_t *buffer)
+{
+  uint16_t end = (uint16_t)startPage + count;
+  uint16_t page = startPage;
+  int16_t total = 0;
+
+  if (end > info->pages)
+    return -1;
+
+  while (page < end) {
+    uint8_t n;
+    int16_t res;
+
+    if (info->fastRead) {
+      n = (end - page > NTAG_FAST_READ_MAX_PAGES) ? NTAG_FAST_READ_MAX_PAGES : (uint8_t)(end - page);
+      res = ntagFastRead(page, page + n - 1, &buffer[total]);
+    }
+    else {
+      uint8_t tmp[NTAG_READ_PAGES * NTAG_PAGE_SIZE];
+
+      // READ always returns 4 pages; only copy what was asked for
+      n = (end - page > NTAG_READ_PAGES) ? NTAG_READ_PAGES : (uint8_t)(end - page);
+      res = ntagReadPage(page, tmp);
+      if (res == sizeof(tmp)) {
+        res = n * NTAG_PAGE_SIZE;
+        memcpy(&buffer[total], tmp, res);
+      }
+    }
+
+    if (res != n * NTAG_PAGE_SIZE)
+      return -1;
+
+    total += res;
+    page += n;
+  }
+
+  return total;
+
+}
+
+/** @brief Read the originality signature with READ_SIG
+ *  @param signature Buffer for NTAG_SIGNATURE_SIZE bytes
+ *  @return true if a full signature was read
+ */
+bool ntagReadSig(uint8_t *signature)
+{
+  uint8_t cmd[2] = { NTAG_CMD_READ_SIG, 0x00 };
+  return rfidTransceive(cmd, 2, signature, NTAG_SIGNATURE_SIZE, NTAG_TIMEOUT(NTAG_SIGNATURE_SIZE)) == NTAG_SIGNATURE_SIZE;
+}
+
+/** @brief Get number of user memory pages (from page 4)
+ *  @param info Tag info from ntagGetVersion
+ */
+uint8_t ntagUserPages(const ntag_info_t *info)
+{
+  // Ultralight EV1 MF0UL11 and the original Ultralight have no dynamic lock bytes
+  if (info->pages <= 20)
+    return info->pages - NTAG_USER_START_PAGE - (info->fastRead ? NTAG_CONFIG_PAGES : 0);
+
+  return info->pages - NTAG_USER_START_PAGE - NTAG_DYNAMIC_LOCK_OFFSET;
+}
+
+/** @brief Write one page with WRITE
+ *  @param page Page number
+ *  @param data 4 bytes
+ *  @return true if the tag acknowledged the write
+ */
+bool ntagWritePage(const uint8_t page, const uint8_t *data)
+{
+  uint8_t cmd[2 + NTAG_PAGE_SIZE] = { NTAG_CMD_WRITE, page };
+
+  memcpy(&cmd[2], data, NTAG_PAGE_SIZE);
+  return rfidTransceiveAck(cmd, sizeof(cmd), NTAG_WRITE_TIMEOUT);
+}
+
+/** @brief Permanently lock the user memory and capability container
+ *  @param info Tag info from ntagGetVersion
+ *  @return true if all lock bytes were written
+ *  @note Lock bits are OTP; WRITE ORs them in, so the other bytes of the
+ *        page are written as 0
+ */
+bool ntagLock(const ntag_info_t *info)
+{
+  uint8_t cc[NTAG_READ_PAGES * NTAG_PAGE_SIZE];
+  uint8_t staticLock[NTAG_PAGE_SIZE] = { 0x00, 0x00, 0xFF, 0xFF };
+  uint8_t dynamicLock[NTAG_PAGE_SIZE] = { 0xFF, 0xFF, 0xFF, 0x00 };
+
+  // Mark the NDEF data read-only in the capability container (page 3)
+  if (ntagReadPage(NTAG_STATIC_LOCK_PAGE + 1, cc) != sizeof(cc))
+    return false;
+  cc[3] = 0x0F;
+  if (!ntagWritePage(NTAG_STATIC_LOCK_PAGE + 1, cc))
+    return false;
+
+  if ((info->pages > 20) && !ntagWritePage(info->pages - NTAG_DYNAMIC_LOCK_OFFSET, dynamicLock))
+    return false;
+
+  // Static lock bits last; they also lock the capability container
+  return ntagWritePage(NTAG_STATIC_LOCK_PAGE, staticLock);
+}
+
+/** @brief Read the whole tag memory
+ *  @param info Tag info from ntagGetVersion
+ *  @param buffer Buffer for the tag memory
+ *  @param len Size of buffer
+ *  @return Number of bytes read, or -1 on error
+ */
+int16_t ntagDump(const ntag_info_t *info, uint8_t *buffer, const uint16_t len)
+{
+  if (len < info->pages * NTAG_PAGE_SIZE)
+    return -1;
+
+  return ntagReadPages(info, 0, info->pages, buffer);
+}
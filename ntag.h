@@ -0,0 +1,38 @@
+/*
+ * ntag.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef NTAG_H_
+#define NTAG_H_
+
+#include "app/framework/include/af.h"
+
+#include "rfid.h"
+
+#define NTAG_PAGE_SIZE            4
+#define NTAG_READ_PAGES           4           /**< Pages returned by a single READ */
+#define NTAG_FAST_READ_MAX_PAGES  (RFID_FIFO_SIZE / NTAG_PAGE_SIZE)
+#define NTAG_USER_START_PAGE      4
+#define NTAG_SIGNATURE_SIZE       32          /**< READ_SIG response (secp128r1 r||s) */
+
+/*! Tag memory layout (from GET_VERSION) */
+typedef struct {
+  uint8_t version[8];                         /**< Raw GET_VERSION response */
+  uint8_t pages;                              /**< Total number of pages */
+  bool fastRead;                              /**< FAST_READ supported */
+} ntag_info_t;
+
+bool ntagGetVersion(ntag_info_t *info);
+int16_t ntagReadPage(uint8_t page, uint8_t *buffer);
+int16_t ntagFastRead(uint8_t startPage, uint8_t endPage, uint8_t *buffer);
+int16_t ntagReadPages(const ntag_info_t *info, uint8_t startPage, uint8_t count, uint8_t *buffer);
+bool ntagReadSig(uint8_t *signature);
+uint8_t ntagUserPages(const ntag_info_t *info);
+bool ntagWritePage(uint8_t page, const uint8_t *data);
+bool ntagLock(const ntag_info_t *info);
+int16_t ntagDump(const ntag_info_t *info, uint8_t *buffer, uint16_t len);
+
+#endif /* NTAG_H_ */
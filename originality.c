@@ -0,0 +1,193 @@
+/*
+ * originality.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "originality.h"
+
+#include "rfid_config.h"
+
+#if RFID_ORIGINALITY_CHECK
+
+#include "ntag.h"
+
+#include "sl_se_manager.h"
+#include "sl_se_manager_signature.h"
+
+#define SECP128R1_SIZE            16
+
+/* Custom curves are only supported by Secure Vault High devices */
+#if defined(SL_SE_KEY_TYPE_ECC_WEIERSTRASS_PRIME_CUSTOM)
+#define ORIGINALITY_SE_VERIFY     1
+#else
+#define ORIGINALITY_SE_VERIFY     0
+#endif
+
+#if !ORIGINALITY_SE_VERIFY
+#error "RFID_ORIGINALITY_CHECK needs secp128r1 in the SE (Secure Vault High); this device cannot verify the signature"
+#endif
+
+/* SEC 2 secp128r1 domain parameters */
+static const uint8_t secp128r1P[SECP128R1_SIZE] = {
+  0xFF, 0xFF, 0xFF, 0xFD, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+static const uint8_t secp128r1N[SECP128R1_SIZE] = {
+  0xFF, 0xFF, 0xFF, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x75, 0xA3, 0x0D, 0x1B, 0x90, 0x38, 0xA1, 0x15
+};
+static const uint8_t secp128r1Gx[SECP128R1_SIZE] = {
+  0x16, 0x1F, 0xF7, 0x52, 0x8B, 0x89, 0x9B, 0x2D, 0x0C, 0x28, 0x60, 0x7C, 0xA5, 0x2C, 0x5B, 0x86
+};
+static const uint8_t secp128r1Gy[SECP128R1_SIZE] = {
+  0xCF, 0x5A, 0xC8, 0x39, 0x5B, 0xAF, 0xEB, 0x13, 0xC0, 0x2D, 0xA2, 0x92, 0xDD, 0xED, 0x7A, 0x83
+};
+static const uint8_t secp128r1A[SECP128R1_SIZE] = {
+  0xFF, 0xFF, 0xFF, 0xFD, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFC
+};
+static const uint8_t secp128r1B[SECP128R1_SIZE] = {
+  0xE8, 0x75, 0x79, 0xC1, 0x10, 0x79, 0xF4, 0x3D, 0xD8, 0x24, 0x99, 0x3C, 0x2C, 0xEE, 0x5E, 0xD3
+};
+
+static const sl_se_custom_weierstrass_prime_domain_t secp128r1 = {
+  .size = SECP128R1_SIZE,
+  .p = secp128r1P,
+  .N = secp128r1N,
+  .Gx = secp128r1Gx,
+  .Gy = secp128r1Gy,
+  .a = secp128r1A,
+  .b = secp128r1B,
+  .a_is_zero = false,
+  .a_is_minus_three = true,
+};
+
+/* NXP NTAG21x / Ultralight EV1 originality public key (X || Y) */
+static const uint8_t nxpPublicKey[2 * SECP128R1_SIZE] = {
+  0x49, 0x4E, 0x1A, 0x38, 0x6D, 0x3D, 0x3C, 0xFE, 0x3D, 0xC1, 0x0E, 0x5D, 0xE6, 0x8A, 0x49, 0x9B,
+  0x1C, 0x20, 0x2D, 0xB5, 0xB1, 0x32, 0x39, 0x3E, 0x89, 0xED, 0x19, 0xFE, 0x5B, 0xE8, 0xBC, 0x61
+};
+
+/* Verified UIDs; cached copy of the ORIGINALITY_UIDS token */
+static tokTypeOriginalityUid verifiedUids[ORIGINALITY_UIDS_ELEMENTS];
+static uint8_t nextUid = 0;
+
+static originality_stats_t stats;
+
+/** @brief Load verified UIDs from NVM3
+ */
+void originalityInit(void)
+{
+  for (uint8_t i = 0; i < ORIGINALITY_UIDS_ELEMENTS; i++)
+    halCommonGetIndexedToken(&verifiedUids[i], TOKEN_ORIGINALITY_UIDS, i);
+
+  memset(&stats, 0, sizeof(stats));
+}
+
+/** @brief Look up a UID in the verified UID cache
+ *  @return true if the UID has been verified before
+ */
+static bool isVerified(const rfid_tag_t *rfid_tag)
+{
+  for (uint8_t i = 0; i < ORIGINALITY_UIDS_ELEMENTS; i++) {
+    if ((verifiedUids[i].size == rfid_tag->size)
+        && (memcmp(verifiedUids[i].uid, rfid_tag->rfid, rfid_tag->size) == 0))
+      return true;
+  }
+
+  return false;
+}
+
+/** @brief Add a UID to the verified UID cache, replacing the oldest entry
+ */
+static void addVerified(const rfid_tag_t *rfid_tag)
+{
+  uint8_t i = nextUid;
+
+  nextUid = (nextUid + 1) % ORIGINALITY_UIDS_ELEMENTS;
+  verifiedUids[i].size = rfid_tag->size;
+  memcpy(verifiedUids[i].uid, rfid_tag->rfid, rfid_tag->size);
+  halCommonSetIndexedToken(TOKEN_ORIGINALITY_UIDS, i, &verifiedUids[i]);
+}
+
+/** @brief Verify an originality signature over a UID
+ *  @param uid 7 byte UID
+ *  @param signature r || s from READ_SIG
+ *  @return ORIGINALITY_VERIFIED if the signature is valid
+ *  @note The UID is signed as is (no hash); it is passed to the SE as a
+ *        zero padded 16 byte digest, which is the same integer.
+ */
+static originality_result_t verifySignature(const uint8_t *uid, const uint8_t *signature)
+{
+  sl_se_command_context_t cmdCtx;
+  uint8_t digest[SECP128R1_SIZE] = { 0 };
+  sl_se_key_descriptor_t key = {
+    .type = SL_SE_KEY_TYPE_ECC_WEIERSTRASS_PRIME_CUSTOM,
+    .flags = SL_SE_KEY_FLAG_ASYMMETRIC_BUFFER_HAS_PUBLIC_KEY | SL_SE_KEY_FLAG_ASYMMETRIC_USES_CUSTOM_DOMAIN,
+    .storage.method = SL_SE_KEY_STORAGE_EXTERNAL_PLAINTEXT,
+    .storage.location.buffer.pointer = (uint8_t *)nxpPublicKey,
+    .storage.location.buffer.size = sizeof(nxpPublicKey),
+    .domain = &secp128r1,
+    .size = SECP128R1_SIZE,
+  };
+
+  memcpy(&digest[SECP128R1_SIZE - ORIGINALITY_UID_SIZE], uid, ORIGINALITY_UID_SIZE);
+
+  if (sl_se_init_command_context(&cmdCtx) != SL_STATUS_OK)
+    return ORIGINALITY_FAILED;
+
+  if (sl_se_ecc_verify(&cmdCtx, &key, SL_SE_HASH_NONE, true, digest, sizeof(digest), signature, NTAG_SIGNATURE_SIZE) != SL_STATUS_OK)
+    return ORIGINALITY_FAILED;
+
+  return ORIGINALITY_VERIFIED;
+}
+
+/** @brief Check that an NTAG/Ultralight EV1 tag is genuine
+ *  @param rfid_tag Selected tag
+ *  @return Result of the check
+ *  @note A UID seen with a valid signature before is trusted without reading
+ *        the signature again; a cache hit costs no RF exchange.
+ */
+originality_result_t originalityCheck(const rfid_tag_t *rfid_tag)
+{
+  uint8_t signature[NTAG_SIGNATURE_SIZE];
+  originality_result_t result;
+  uint32_t start;
+
+  if (rfid_tag->size != ORIGINALITY_UID_SIZE)
+    return ORIGINALITY_FAILED;
+
+  if (isVerified(rfid_tag)) {
+    stats.hits++;
+    return ORIGINALITY_VERIFIED;
+  }
+
+  stats.misses++;
+  start = halCommonGetInt32uMillisecondTick();
+
+  if (ntagReadSig(signature))
+    result = verifySignature(rfid_tag->rfid, signature);
+  else
+    result = ORIGINALITY_FAILED;
+
+  stats.lastVerifyMs = halCommonGetInt32uMillisecondTick() - start;
+  stats.verifyMs += stats.lastVerifyMs;
+
+  if (result == ORIGINALITY_VERIFIED)
+    addVerified(rfid_tag);
+  else
+    stats.failures++;
+
+  return result;
+}
+
+/** @brief Print cache hit rate and verify time
+ */
+void originalityPrintStats(void)
+{
+  uint32_t checks = stats.hits + stats.misses;
+
+  emberAfCorePrintln("originality: %d checks, %d hits (%d%%), %d failures", checks, stats.hits, checks ? (stats.hits * 100) / checks : 0, stats.failures);
+  emberAfCorePrintln("originality: verify %d ms last, %d ms avg", stats.lastVerifyMs, stats.misses ? stats.verifyMs / stats.misses : 0);
+}
+
+#endif // RFID_ORIGINALITY_CHECK
@@ -0,0 +1,36 @@
+/*
+ * originality.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef ORIGINALITY_H_
+#define ORIGINALITY_H_
+
+#include "app/framework/include/af.h"
+
+#include "rfid.h"
+
+#define ORIGINALITY_UID_SIZE      7
+
+/*! Result of an originality check */
+typedef enum {
+  ORIGINALITY_VERIFIED = 0,                   /**< Signature verified, or UID in cache */
+  ORIGINALITY_FAILED                          /**< No signature, or signature did not verify */
+} originality_result_t;
+
+/*! Originality check statistics */
+typedef struct {
+  uint32_t hits;                              /**< Checks answered from the UID cache */
+  uint32_t misses;                            /**< Checks that read and verified the signature */
+  uint32_t failures;                          /**< Signatures that did not verify */
+  uint32_t verifyMs;                          /**< Total time spent in READ_SIG + verify */
+  uint32_t lastVerifyMs;                      /**< Time of the last READ_SIG + verify */
+} originality_stats_t;
+
+void originalityInit(void);
+originality_result_t originalityCheck(const rfid_tag_t *rfid_tag);
+void originalityPrintStats(void);
+
+#endif /* ORIGINALITY_H_ */
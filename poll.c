@@ -0,0 +1,222 @@
+/*
+ * poll.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "poll.h"
+
+#include "rfid_config.h"
+#include "iso15693.h"
+
+#include "sl_sleeptimer.h"
+
+#define POLL_PROTOCOLS            4
+
+/* Hit score; each poll decays all scores by 1/8 and adds this to the winner */
+#define POLL_HIT_SCORE            32
+
+/* ISO14443B REQB: APf, AFI (all families), PARAM (REQB, 1 slot) */
+#define ISO14443B_APF             0x05
+#define ATQB_SIZE                 12
+
+/* Probe frame wait time in T0 ticks (4.72 us) */
+#define PROBE_TIMEOUT             ((uint16_t)((RFID_POLL_PROBE_TIMEOUT * 100UL) / 472))
+
+/* FeliCa polling: length, command, system code (wildcard), request code, time slot */
+#define FELICA_CMD_POLLING        0x00
+#define FELICA_POLLING_RESP_SIZE  18
+#define FELICA_IDM_SIZE           8
+
+typedef struct {
+  uint8_t protocol;
+  bool enabled;
+  uint16_t score;
+  uint16_t hits;
+} poll_entry_t;
+
+static poll_entry_t pollOrder[POLL_PROTOCOLS] = {
+  { MFRC630_PROTO_ISO14443A_106, RFID_POLL_ISO14443A, 0, 0 },
+  { MFRC630_PROTO_ISO14443B_106, RFID_POLL_ISO14443B, 0, 0 },
+  { MFRC630_PROTO_FELICA_212, RFID_POLL_FELICA, 0, 0 },
+  { MFRC630_PROTO_ISO15693, RFID_POLL_ISO15693, 0, 0 }
+};
+
+/* ATQA from pollProbe; the card is READY and the next ISO14443A poll selects it directly */
+static uint16_t probedAtqa = 0;
+static uint32_t probes = 0;
+static uint32_t probeRejects = 0;
+static uint32_t probeUs = 0;                  /**< Time of the last probe, reader setup and WUPA */
+
+static bool iso14443bRequest(rfid_tag_t *rfid_tag)
+{
+  uint8_t req[3] = { ISO14443B_APF, 0x00, 0x00 };
+  uint8_t atqb[ATQB_SIZE];
+
+  if ((rfidTransceive(req, sizeof(req), atqb, sizeof(atqb), RFID_DEFAULT_TIMEOUT) != ATQB_SIZE) || (atqb[0] != 0x50))
+    return false;
+
+  // PUPI is used as UID
+  memset(rfid_tag, 0, sizeof(rfid_tag_t));
+  memcpy(rfid_tag->rfid, &atqb[1], 4);
+  rfid_tag->size = 4;
+  return true;
+}
+
+static bool felicaPoll(rfid_tag_t *rfid_tag)
+{
+  uint8_t req[6] = { sizeof(req), FELICA_CMD_POLLING, 0xFF, 0xFF, 0x00, 0x00 };
+  uint8_t resp[FELICA_POLLING_RESP_SIZE];
+
+  if ((rfidTransceive(req, sizeof(req), resp, sizeof(resp), RFID_DEFAULT_TIMEOUT) != FELICA_POLLING_RESP_SIZE) || (resp[1] != FELICA_CMD_POLLING + 1))
+    return false;
+
+  // IDm is used as UID
+  memset(rfid_tag, 0, sizeof(rfid_tag_t));
+  memcpy(rfid_tag->rfid, &resp[2], FELICA_IDM_SIZE);
+  rfid_tag->size = FELICA_IDM_SIZE;
+  return true;
+}
+
+/** @brief Switch protocol and look for a tag
+ *  @param protocol MFRC630_PROTO_*
+ *  @param rfid_tag Tag; filled in on success
+ *  @return true if a tag answered
+ */
+static bool pollProtocol(const uint8_t protocol, rfid_tag_t *rfid_tag)
+{
+  bool found = false;
+
+  // ISO14443A also needs the board specific antenna settings; a probe has loaded them already
+  if (protocol == MFRC630_PROTO_ISO14443A_106) {
+    if (probedAtqa == 0)
+      rfidInit();
+  }
+  else {
+    probedAtqa = 0;
+    if (!rfidLoadProtocol(protocol))
+      return false;
+  }
+
+  switch (protocol) {
+    case MFRC630_PROTO_ISO14443A_106:
+      found = (probedAtqa != 0) ? readRfidTagSelect(rfid_tag, probedAtqa) : readRfidTag(rfid_tag);
+      probedAtqa = 0;
+      break;
+    case MFRC630_PROTO_ISO14443B_106:
+      found = iso14443bRequest(rfid_tag);
+      break;
+    case MFRC630_PROTO_FELICA_212:
+      found = felicaPoll(rfid_tag);
+      break;
+    case MFRC630_PROTO_ISO15693:
+      found = (iso15693Inventory(rfid_tag, 1) == 1);
+      break;
+  }
+
+  if (found)
+    rfid_tag->protocol = protocol;
+
+  return found;
+
+}
+
+/** @brief Update scores and keep the poll order sorted by score
+ *  @param hit Index of protocol that answered
+ */
+static void updateOrder(const uint8_t hit)
+{
+  for (uint8_t i = 0; i < POLL_PROTOCOLS; i++)
+    pollOrder[i].score -= pollOrder[i].score / 8;
+
+  pollOrder[hit].score += POLL_HIT_SCORE;
+  pollOrder[hit].hits++;
+
+  // Insertion sort; at most a few swaps since only one score went up
+  for (uint8_t i = hit; i > 0 && pollOrder[i].score > pollOrder[i - 1].score; i--) {
+    poll_entry_t tmp = pollOrder[i];
+    pollOrder[i] = pollOrder[i - 1];
+    pollOrder[i - 1] = tmp;
+  }
+}
+
+/** @brief Reset poll statistics
+ */
+void pollInit(void)
+{
+  for (uint8_t i = 0; i < POLL_PROTOCOLS; i++) {
+    pollOrder[i].score = 0;
+    pollOrder[i].hits = 0;
+  }
+
+  probedAtqa = 0;
+  probes = 0;
+  probeRejects = 0;
+  probeUs = 0;
+}
+
+/** @brief Cheap check for a card before a full poll
+ *  @return false if nothing can be in the field, true if pollTag should run
+ *  @note One WUPA with a RFID_POLL_PROBE_TIMEOUT frame wait time. A card
+ *        that answers is left READY and selected by the next pollTag
+ *        without another request. The other protocols have no cheaper
+ *        check than their poll, so with any of them enabled this only
+ *        returns false if ISO14443A is the only protocol.
+ */
+bool pollProbe(void)
+{
+  probedAtqa = 0;
+
+  if (!RFID_POLL_PROBE || !RFID_POLL_ISO14443A)
+    return true;
+
+  uint32_t start = sl_sleeptimer_get_tick_count();
+
+  probes++;
+  rfidInit();
+  probedAtqa = iso14443aCommandTimeout(ISO14443_CMD_WUPA, PROBE_TIMEOUT);
+  probeUs = (uint32_t)(((uint64_t)(sl_sleeptimer_get_tick_count() - start) * 1000000UL) / sl_sleeptimer_get_timer_frequency());
+
+  if ((probedAtqa != 0) || RFID_POLL_ISO14443B || RFID_POLL_FELICA || RFID_POLL_ISO15693)
+    return true;
+
+  probeRejects++;
+  return false;
+
+}
+
+/** @brief Poll enabled protocols, most frequently hit first
+ *  @param rfid_tag Tag; filled in on success
+ *  @return true if a tag answered
+ *  @note Stops at the first protocol that answers
+ */
+bool pollTag(rfid_tag_t *rfid_tag)
+{
+  for (uint8_t i = 0; i < POLL_PROTOCOLS; i++) {
+    if (!pollOrder[i].enabled)
+      continue;
+
+    if (pollProtocol(pollOrder[i].protocol, rfid_tag)) {
+      updateOrder(i);
+      return true;
+    }
+  }
+
+  return false;
+
+}
+
+/** @brief Print poll order and hit counts
+ */
+void pollPrintStats(void)
+{
+  for (uint8_t i = 0; i < POLL_PROTOCOLS; i++) {
+    emberAfCorePrintln("protocol 0x%x: %s, score = %d, hits = %d",
+                       pollOrder[i].protocol,
+                       pollOrder[i].enabled ? "enabled" : "disabled",
+                       pollOrder[i].score,
+                       pollOrder[i].hits);
+  }
+  emberAfCorePrintln("probes = %d, rejected = %d, last probe %d us", probes, probeRejects, probeUs);
+}
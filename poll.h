@@ -0,0 +1,20 @@
+/*
+ * poll.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef POLL_H_
+#define POLL_H_
+
+#include "app/framework/include/af.h"
+
+#include "rfid.h"
+
+void pollInit(void);
+bool pollProbe(void);
+bool pollTag(rfid_tag_t *rfid_tag);
+void pollPrintStats(void);
+
+#endif /* POLL_H_ */
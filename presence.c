@@ -0,0 +1,96 @@
+/*
+ * presence.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "presence.h"
+
+#include "rfid_config.h"
+
+/* Cascade tag; first byte of UID CL1 for 7 and 10 byte UIDs */
+#define CASCADE_TAG               0x88
+
+static rfid_tag_t presentTag;
+static uint8_t presentUid[4];                 /**< UID bytes answered at cascade level 1 */
+static bool tracking = false;
+static uint8_t misses = 0;
+
+/** @brief Start tracking a tag that has just been read
+ *  @param rfid_tag Tag
+ *  @return true if the tag is tracked; only ISO14443A tags can be
+ *          probed with WUPA, and tracking may be disabled
+ */
+bool presenceStart(const rfid_tag_t *rfid_tag)
+{
+  if ((RFID_PRESENCE_INTERVAL == 0) || (rfid_tag->protocol != MFRC630_PROTO_ISO14443A_106))
+    return false;
+
+  memcpy(&presentTag, rfid_tag, sizeof(rfid_tag_t));
+  if (rfid_tag->size == 4) {
+    memcpy(presentUid, rfid_tag->rfid, 4);
+  }
+  else {
+    presentUid[0] = CASCADE_TAG;
+    memcpy(&presentUid[1], rfid_tag->rfid, 3);
+  }
+  tracking = true;
+  misses = 0;
+
+  // The field off resets the tag; no need to halt it first
+  rfidFieldOff();
+  return true;
+}
+
+/** @brief Check if the tracked tag is still in the field
+ *  @return PRESENCE_DEPARTED once RFID_PRESENCE_MISSES probes in a row got
+ *          no answer, or another tag answered
+ *  @note A probe is one WUPA (7 bit frame) and one cascade level 1
+ *        anticollision, matched on ATQA and the UID bytes of that level;
+ *        no select, and no HLTA since the field is switched off after it
+ */
+presence_event_t presenceProbe(void)
+{
+  uint8_t uid[4];
+  uint16_t atqa;
+  bool answered;
+
+  if (!tracking)
+    return PRESENCE_NONE;
+
+  rfidInit();
+  atqa = iso14443aCommand(ISO14443_CMD_WUPA);
+  answered = (atqa != 0) && iso14443aAnticollision(uid);
+
+  rfidFieldOff();
+
+  if (answered && (atqa == presentTag.atqa) && (memcmp(uid, presentUid, 4) == 0)) {
+    misses = 0;
+    return PRESENCE_PRESENT;
+  }
+
+  // Another tag in the field counts as a departure straight away; a
+  // collision of the tracked tag with another one counts as a miss
+  if (answered || (++misses >= RFID_PRESENCE_MISSES)) {
+    tracking = false;
+    return PRESENCE_DEPARTED;
+  }
+
+  return PRESENCE_PRESENT;
+
+}
+
+/** @brief Get the tracked (or last tracked) tag
+ */
+const rfid_tag_t *presenceTag(void)
+{
+  return &presentTag;
+}
+
+/** @brief Stop tracking without a departure
+ */
+void presenceStop(void)
+{
+  tracking = false;
+}
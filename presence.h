@@ -0,0 +1,27 @@
+/*
+ * presence.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef PRESENCE_H_
+#define PRESENCE_H_
+
+#include "app/framework/include/af.h"
+
+#include "rfid.h"
+
+/*! Result of a presence probe */
+typedef enum {
+  PRESENCE_NONE = 0,                          /**< No tag tracked */
+  PRESENCE_PRESENT,                           /**< Tag still in the field */
+  PRESENCE_DEPARTED                           /**< Tag left the field */
+} presence_event_t;
+
+bool presenceStart(const rfid_tag_t *rfid_tag);
+presence_event_t presenceProbe(void);
+const rfid_tag_t *presenceTag(void);
+void presenceStop(void);
+
+#endif /* PRESENCE_H_ */
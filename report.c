@@ -0,0 +1,137 @@
+/*
+ * report.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "report.h"
+
+#include "energy.h"
+
+/** @brief Check if reports can be sent
+ */
+static bool joined(void)
+{
+  if (emberAfNetworkState() != EMBER_JOINED_NETWORK) {
+    emberAfCorePrintln("not joined; not reported");
+    return false;
+  }
+
+  return true;
+}
+
+/** @brief Send the filled report command to the coordinator
+ *  @return true if the report was sent
+ */
+static bool sendToCoordinator(void)
+{
+  emberAfSetCommandEndpoints(REPORT_ENDPOINT, REPORT_ENDPOINT);
+
+  energyPhaseBegin(ENERGY_PHASE_RADIO);
+  EmberStatus status = emberAfSendCommandUnicast(EMBER_OUTGOING_DIRECT, EMBER_ZIGBEE_COORDINATOR_ADDRESS);
+  energyPhaseEnd(ENERGY_PHASE_RADIO);
+  if (status != EMBER_SUCCESS) {
+    emberAfCorePrintln("failed to send report: 0x%x", status);
+    return false;
+  }
+
+  energyTx();
+  return true;
+
+}
+
+/** @brief Send a tag report to the coordinator
+ *  @param command REPORT_CMD_*
+ *  @param rfid_tag Tag
+ *  @return true if the report was sent
+ */
+static bool sendReport(const uint8_t command, const rfid_tag_t *rfid_tag)
+{
+  if (!joined())
+    return false;
+
+  emberAfFillExternalManufacturerSpecificBuffer((ZCL_CLUSTER_SPECIFIC_COMMAND
+                                                 | ZCL_FRAME_CONTROL_CLIENT_TO_SERVER
+                                                 | ZCL_MANUFACTURER_SPECIFIC_MASK
+                                                 | ZCL_DISABLE_DEFAULT_RESPONSE_MASK),
+                                                REPORT_CLUSTER_ID,
+                                                REPORT_MANUFACTURER_CODE,
+                                                command,
+                                                "uub",
+                                                rfid_tag->protocol,
+                                                rfid_tag->size,
+                                                rfid_tag->rfid,
+                                                rfid_tag->size);
+
+  return sendToCoordinator();
+
+}
+
+/** @brief Report a tag read (arrival) to the coordinator
+ *  @param rfid_tag Tag
+ *  @return true if the report was sent
+ */
+bool reportTag(const rfid_tag_t *rfid_tag)
+{
+  return sendReport(REPORT_CMD_TAG, rfid_tag);
+}
+
+/** @brief Report that a tag has left the field
+ *  @param rfid_tag Tag
+ *  @return true if the report was sent
+ */
+bool reportDeparture(const rfid_tag_t *rfid_tag)
+{
+  return sendReport(REPORT_CMD_DEPARTURE, rfid_tag);
+}
+
+/** @brief Report a new LPCD detection threshold
+ *  @param threshold Window half-width (ADC counts)
+ *  @param falseWakes False wakes since boot
+ *  @return true if the report was sent
+ */
+bool reportLpcdThreshold(const uint8_t threshold, const uint32_t falseWakes)
+{
+  if (!joined())
+    return false;
+
+  emberAfFillExternalManufacturerSpecificBuffer((ZCL_CLUSTER_SPECIFIC_COMMAND
+                                                 | ZCL_FRAME_CONTROL_CLIENT_TO_SERVER
+                                                 | ZCL_MANUFACTURER_SPECIFIC_MASK
+                                                 | ZCL_DISABLE_DEFAULT_RESPONSE_MASK),
+                                                REPORT_CLUSTER_ID,
+                                                REPORT_MANUFACTURER_CODE,
+                                                REPORT_CMD_LPCD_THRESHOLD,
+                                                "uw",
+                                                threshold,
+                                                falseWakes);
+
+  return sendToCoordinator();
+}
+
+/** @brief Report the estimated charge use
+ *  @param perDay Charge per day at the rate since boot (uAh)
+ *  @param perTap Charge per tag read (uC)
+ *  @param taps Tag reads since boot
+ *  @return true if the report was sent
+ */
+bool reportEnergy(const uint32_t perDay, const uint32_t perTap, const uint32_t taps)
+{
+  if (!joined())
+    return false;
+
+  emberAfFillExternalManufacturerSpecificBuffer((ZCL_CLUSTER_SPECIFIC_COMMAND
+                                                 | ZCL_FRAME_CONTROL_CLIENT_TO_SERVER
+                                                 | ZCL_MANUFACTURER_SPECIFIC_MASK
+                                                 | ZCL_DISABLE_DEFAULT_RESPONSE_MASK),
+                                                REPORT_CLUSTER_ID,
+                                                REPORT_MANUFACTURER_CODE,
+                                                REPORT_CMD_ENERGY,
+                                                "www",
+                                                perDay,
+                                                perTap,
+                                                taps);
+
+  return sendToCoordinator();
+}
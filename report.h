@@ -0,0 +1,29 @@
+/*
+ * report.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef REPORT_H_
+#define REPORT_H_
+
+#include "app/framework/include/af.h"
+
+#include "rfid.h"
+
+/*! Manufacturer specific tag report cluster */
+#define REPORT_CLUSTER_ID         0xFC00
+#define REPORT_MANUFACTURER_CODE  0x1002
+#define REPORT_CMD_TAG            0x00        /**< Tag arrived (read) */
+#define REPORT_CMD_DEPARTURE      0x01        /**< Tag left the field */
+#define REPORT_CMD_LPCD_THRESHOLD 0x02        /**< LPCD threshold changed */
+#define REPORT_CMD_ENERGY         0x03        /**< Estimated charge use */
+#define REPORT_ENDPOINT           1
+
+bool reportTag(const rfid_tag_t *rfid_tag);
+bool reportDeparture(const rfid_tag_t *rfid_tag);
+bool reportLpcdThreshold(uint8_t threshold, uint32_t falseWakes);
+bool reportEnergy(uint32_t perDay, uint32_t perTap, uint32_t taps);
+
+#endif /* REPORT_H_ */
@@ -19,14 +19,26 @@ extern uint8_t rfidAddress;
 
 #define MAX_BUF_SIZE        32
 
-#define LPCD_THRESHOLD_HIGH 3
-#define LPCD_THRESHOLD_LOW  3
-
 uint8_t antcfg_iso14443a_106[18] = { 0x8e, 0x12, 0x39, 0x0a, 0x18, 0x18,
                                      0x0f, 0x21, 0x00, 0xc0, 0x12, 0xcf,
                                      0x00, 0x04, 0x90, 0x5c, 0x12, 0x0a };
 
-uint8_t LPCD_QMin = 0, LPCD_QMax = 0, LPCD_IMin = 0;
+/* Board defaults (TX_AMP, DRV_CON and the receiver part of antcfg_iso14443a_106) */
+static const rfid_antenna_t defaultAntenna = {
+  .txAmp = 0x12,
+  .drvCon = 0x39,
+  .rxThreshold = 0x5c,
+  .rxAna = 0x0a,
+};
+
+static rfid_antenna_t antenna = {
+  .txAmp = 0x12,
+  .drvCon = 0x39,
+  .rxThreshold = 0x5c,
+  .rxAna = 0x0a,
+};
+
+static uint8_t currentProtocol = MFRC630_PROTO_ISO14443A_106;
 
 /*
 void rfidHardReset()
@@ -120,320 +132,375 @@ uint8_t read8(uint8_t reg)
   return res;
 }
 
-static void getWindowValues()
+void rfidInit() {
+  rfidLoadProtocol(MFRC630_PROTO_ISO14443A_106);
+  writeBuffer(MFRC630_REG_DRV_MOD, sizeof(antcfg_iso14443a_106), antcfg_iso14443a_106);
+  write8(MFRC630_REG_DRV_MOD, 0x8E);                /* Driver mode register */
+  write8(MFRC630_REG_TX_AMP, antenna.txAmp);        /* Transmitter amplifier register */
+  write8(MFRC630_REG_DRV_CON, antenna.drvCon);      /* Driver configuration register */
+  write8(MFRC630_REG_TXL, 0x06);                    /* Transmitter register */
+  write8(MFRC630_REG_RX_THRESHOLD, antenna.rxThreshold); /* Receiver threshold register */
+  write8(MFRC630_REG_RX_ANA, antenna.rxAna);        /* Receiver analog register */
+}
+
+/** @brief Set the transmitter and receiver settings used by rfidInit
+ *  @param settings Settings; NULL restores the board defaults
+ *  @note Takes effect at the next rfidInit
+ */
+void rfidSetAntenna(const rfid_antenna_t *settings)
 {
-  // Get I and Q calues
-  uint8_t iVal = read8(MFRC630_REG_LPCD_I_RESULT);
-  uint8_t qVal = read8(MFRC630_REG_LPCD_Q_RESULT);
+  antenna = settings ? *settings : defaultAntenna;
+}
 
-  // Use recommended threshold value
-  //const uint8_t threshold = 1;
+/** @brief Settings used by rfidInit
+ */
+const rfid_antenna_t *rfidAntenna(void)
+{
+  return &antenna;
+}
 
-  // Calculate detection window values
-  uint8_t bQMin = qVal - LPCD_THRESHOLD_LOW;
-  uint8_t bQMax = qVal + LPCD_THRESHOLD_HIGH;
-  uint8_t bIMin = iVal - LPCD_THRESHOLD_LOW;
-  uint8_t bIMax = iVal + LPCD_THRESHOLD_HIGH;
+/** @brief Board default settings (the Adafruit CLRC663 breakout values)
+ */
+const rfid_antenna_t *rfidDefaultAntenna(void)
+{
+  return &defaultAntenna;
+}
 
-  /*
-  bQMin = 18;
-  bQMax = 18;
-  bIMin = 22;
-  bIMax = 22;
-  */
+uint16_t iso14443aRequest()
+{
+  return iso14443aCommand(ISO14443_CMD_REQA);
+}
 
-  emberAfCorePrintln("bQMin = %d, bQMax = %d, bIMin = %d, bIMax = %d", bQMin, bQMax, bIMin, bIMax);
+/** @brief Put the selected card in HALT state (HLTA)
+ *  @return true if the card did not answer, i.e. it is halted
+ *  @note A halted card only answers WUPA
+ */
+bool iso14443aHalt(void)
+{
+  uint8_t hlta[2] = { ISO14443_CMD_HLTA, 0x00 };
+  uint8_t resp;
+  uint8_t error;
 
-  // Calculate register values
-  LPCD_QMin = bQMin | ((bIMax & 0b00110000) << 2);
-  LPCD_QMax = bQMax | ((bIMax & 0b00001100) << 4);
-  LPCD_IMin = bIMin | ((bIMax & 0b00000011) << 6);
+  return rfidExchange(hlta, sizeof(hlta), &resp, 1, RFID_DEFAULT_TIMEOUT, &error) < 0;
+}
 
-/*
-  LPCD_QMin = 145;
-  LPCD_QMax = 19;
-  LPCD_IMin = 34;
-*/
+/** @brief Switch off the RF field
+ *  @note rfidInit or rfidLoadProtocol is needed before the next exchange
+ */
+void rfidFieldOff(void)
+{
+  write8(MFRC630_REG_DRV_MOD, read8(MFRC630_REG_DRV_MOD) & ~MFRC630_DRV_MOD_TXEN);
+}
 
-  /*
-  LPCD_QMin = 0xff;
-  LPCD_QMax = 0xff;
-  LPCD_IMin = 0xff;
-  */
+void clearFIFO()
+{
+  uint8_t ctrl = read8(MFRC630_REG_FIFO_CONTROL);
+  write8(MFRC630_REG_FIFO_CONTROL, ctrl | (1 << 4));
+}
 
-  emberAfCorePrintln("LPCD_QMin = %d, LPCD_QMax = %d, LPCD_IMin = %d", LPCD_QMin, LPCD_QMax, LPCD_IMin);
+static int16_t fifoLength(void)
+{
+  /* Read the MFRC630_REG_FIFO_LENGTH register */
+  /* In 512 byte mode, the upper two bits are stored in FIFO_CONTROL */
+  uint8_t hi = read8(MFRC630_REG_FIFO_CONTROL);
+  uint8_t lo = read8(MFRC630_REG_FIFO_LENGTH);
 
+  /* Determine len based on FIFO size (255 byte or 512 byte mode) */
+  return (hi & 0x80) ? lo : (((hi & 0x3) << 8) | lo);
 }
 
-void printQIValues(void)
+int16_t readFIFO(uint16_t len, uint8_t *buffer)
 {
-  // Get I and Q calues
-  uint8_t iVal = read8(MFRC630_REG_LPCD_I_RESULT);
-  uint8_t qVal = read8(MFRC630_REG_LPCD_Q_RESULT);
+  int16_t ctr = 0;
+
+  /* Check for 512 byte overflow */
+  if (len > 512) {
+    return -1;
+  }
 
-  // Calculate detection window values
-  uint8_t bQMin = qVal - LPCD_THRESHOLD_LOW;
-  uint8_t bQMax = qVal + LPCD_THRESHOLD_HIGH;
-  uint8_t bIMin = iVal - LPCD_THRESHOLD_LOW;
-  uint8_t bIMax = iVal + LPCD_THRESHOLD_HIGH;
+  /*
+   * Read len bytes from the FIFO. The register address is not incremented
+   * when reading MFRC630_REG_FIFO_DATA, so the FIFO can be drained with
+   * burst reads instead of one I2C transaction per byte.
+   */
+  while (ctr < len) {
+    uint8_t chunk = (len - ctr > 255) ? 255 : (uint8_t)(len - ctr);
+    if (i2cReadRegister(rfidAddress, MFRC630_REG_FIFO_DATA, &buffer[ctr], chunk) != EMBER_SUCCESS) {
+      break;
+    }
+    ctr += chunk;
+  }
 
-  emberAfCorePrintln("bQMin = %d, bQMax = %d, bIMin = %d, bIMax = %d", bQMin, bQMax, bIMin, bIMax);
+  return ctr;
 
 }
 
-static void getWindowValuesHPG()
+int16_t writeFIFO(uint16_t len, uint8_t *buffer)
 {
-  // Get I and Q calues
-  uint8_t iVal = read8(MFRC630_REG_LPCD_I_RESULT);
-  uint8_t qVal = read8(MFRC630_REG_LPCD_Q_RESULT);
-  emberAfCorePrintln("ival %d, qval = %d ", iVal, qVal);
-
-  // Use recommended threshold value
-  const uint8_t threshold = 3;
+  int counter = 0;
 
-  // Calculate detection window values
-  uint8_t bQMin = 0;
-  if(qVal >= qVal - threshold){             //check for wrapping
-      bQMin = qVal - threshold;
-  }
-  uint8_t bQMax = 255;
-  if(qVal <= qVal + threshold){             //check for wrapping
-      bQMax = qVal + threshold;
+  /* Check for 512 byte overflow */
+  if (len > 512) {
+    return -1;
   }
 
-  uint8_t bIMin = 0;
-  if(iVal >= iVal - threshold){             //check for wrapping
-      bIMin = iVal - threshold;
-  }
-  uint8_t bIMax = 255;
-  if(iVal <= iVal + threshold){             //check for wrapping
-      bIMax = iVal + threshold;
+  /* Write len bytes to the FIFO */
+  for (uint16_t i = 0; i < len; i++) {
+    write8(MFRC630_REG_FIFO_DATA, buffer[i]);
+    counter++;
   }
-//  uint8_t bIMax = iVal + threshold;
 
-//  emberAfCorePrintln("bqMin = %d, bqMax = %d, biMin = %d, biMax = %d ", bQMin, bQMax, bIMin, bIMax);
-
-  // Calculate register values
-  LPCD_QMin = bQMin | ((bIMax & 0b00110000) << 2);
-  LPCD_QMax = bQMax | ((bIMax & 0b00001100) << 4);
-  LPCD_IMin = bIMin | ((bIMax & 0b00000011) << 6);
-
-  emberAfCorePrintln("LPCD_QMin = %d, LPCD_QMax = %d, LPCD_IMin = %d", LPCD_QMin, LPCD_QMax, LPCD_IMin);
+  return counter;
 
 }
 
-void rfidLpcdInitHPG(void)
+/** @brief Run a chip command and wait for it to finish
+ *  @param command Command (MFRC630_CMD_*)
+ *  @param paramlen Length of command parameters
+ *  @param params Command parameters (written to the FIFO)
+ *  @param timeout Max. time to wait in ms
+ *  @return true if the command finished without error
+ */
+bool rfidCommand(uint8_t command, uint8_t paramlen, uint8_t *params, uint16_t timeout)
 {
-  // Perform SW reset, then idle
-  getWindowValuesHPG();
-  rfidSoftReset();
-  //halCommonDelayMilliseconds(100);
-  //update window values
-  write8(MFRC630_REG_LPCD_QMIN, LPCD_QMin);
-  write8(MFRC630_REG_LPCD_QMAX, LPCD_QMax);
-  write8(MFRC630_REG_LPCD_IMIN, LPCD_IMin);
-
-  // LPCD (low power card detect) config
-
-  // Write T3 reload value(hi, lo)
-  write8(MFRC630_REG_T3_RELOAD_HI, 0x07);   // Write default T3 reload value Hi
-  write8(MFRC630_REG_T3_RELOAD_LO, 0xF2);   // Write default T3 reload value Lo
+  uint8_t irqval = 0;
+  uint32_t start = halCommonGetInt32uMillisecondTick();
 
-  // Write T4 reload value
-  write8(MFRC630_REG_T4_RELOAD_HI, 0x00);   // Write min. T4 reload value Hi
-  write8(MFRC630_REG_T4_RELOAD_LO, 0x13);   // Write min. T4 reload value Lo
+  /* Clear the interrupts. */
+  write8(MFRC630_REG_IRQ0, 0b01111111);
+  write8(MFRC630_REG_IRQ1, 0b00111111);
 
-  // Configure T4 for AutoLPCD and AutoRestart/Autowakeup.Use 2Khz LFO, Start T4
-  write8(MFRC630_REG_T4_CONTROL, 0xdf);     // Config T4 for AutoLPCD & AutoRestart. Set AutoTrimm bit. Start T4.
+  /* Send the command. */
+  writeParamCommand(command, paramlen, params);
 
-  // Clear LPCD result
-  write8(MFRC630_REG_LPCD_Q_RESULT, 0x40);
+  /* Wait until the command terminates by itself, or an error occurs. */
+  while (!(irqval & (MFRC630IRQ0_IDLEIRQ | MFRC630IRQ0_ERRIRQ))) {
+    if (elapsedTimeInt32u(start, halCommonGetInt32uMillisecondTick()) > timeout) {
+      writeCommand(MFRC630_CMD_IDLE);
+      emberAfCorePrintln("ERROR: command 0x%x timed out", command);
+      return false;
+    }
+    irqval = read8(MFRC630_REG_IRQ0);
+  }
 
-  // Set Mix2Adc bit
-  write8(MFRC630_REG_RCV, 0x52);
+  if (irqval & MFRC630IRQ0_ERRIRQ) {
+    uint8_t error = read8(MFRC630_REG_ERROR);
+    if (error) {
+      printError(error);
+      return false;
+    }
+  }
 
-  //******Backup current RxAna setting
-  //******GR  39    // Response:  00
+  return true;
 
-  // Raise receiver gain to maximum
-  write8(MFRC630_REG_RX_ANA, 0x03);         // Raise receiver gain to maximum
+}
 
-  // Wait until T4 is started
-  while(read8(MFRC630_REG_T4_CONTROL) != 0x9f) {};
+/** @brief Switch protocol (LOADPROTOCOL)
+ *  @param protocol MFRC630_PROTO_* used for both RX and TX
+ *  @return true if the protocol was loaded
+ *  @note Loads the protocol registers from the EEPROM in one command
+ */
+bool rfidLoadProtocol(uint8_t protocol)
+{
+  uint8_t params[2] = { protocol, protocol };
 
-  // Flush cmd and FIFO. Clear all IRQ flags
-  write8(MFRC630_REG_COMMAND, 0x00);
-  write8(MFRC630_REG_FIFO_CONTROL, 0xb0);
-  write8(MFRC630_REG_IRQ0, 0b01111111); //clear interrupts
-  write8(MFRC630_REG_IRQ1, 0b01111111); //clear interrupts
-  halCommonDelayMilliseconds(100);
-  write8(MFRC630_REG_IRQ0, 0b11110000); //set IRQ0 set/clear|HiAlertIRQ|LoAlertIRQ|IdleIRQ  |TxIRQ    |RxIRQ    |ErrIRQ   |RxSOFIrq            ***set IRQ0 interrupts
-  write8(MFRC630_REG_IRQ1, 0b11100000); //set IRQ1 set/clear|GlobalIRQ |LPCD_IRQ  |Timer4IRQ|Timer3IRQ|Timer2IRQ|Timer1IRQ|Timer0IRQ           ***set IRQ1 interrupts
-  // Enable IRQ sources: Idle and PLCD
-  write8(MFRC630_REG_IRQ0EN, 0b01110000);  //IRQ_Inv    |Hi AlertIRQEn|Lo AlertIRQEn|IdleIRQEn  |TxIRQEn    |RxIRQEn    |ErrIRQEn   |RxSOFIRQEn          ***set IRQ0En interrupts
-  write8(MFRC630_REG_IRQ1EN, 0b01110000);  //IRQPushPull|IRQPinEN     |LPCD_IRQEN   |Timer4IRQEn|Timer3IRQEn|Timer2IRQEn|Timer1IRQEn|Timer0IRQEn         ***set IRQ1En interrupts
-  //set/clear  |GlobalIRQ    |LPCD_IRQ     |Timer4IRQ  |Timer3IRQ  |Timer2IRQ  |Timer1IRQ  |Timer0IRQ           ***set IRQ1 interrupts
+  if (!rfidCommand(MFRC630_CMD_LOADPROTOCOL, 2, params, 10))
+    return false;
 
-  //> Start RC663 cmd "Low power card detection". Enter PowerDown mode.
-  //write8(MFRC630_REG_COMMAND, 0b10000001);
+  currentProtocol = protocol;
+  return true;
+}
 
-  // Start RC663 cmd "Low power card detection". Enter PowerDown mode.
-//  writeCommand(MFRC630_CMD_IDLE);
-  writeCommand(MFRC630_CMD_LPCD);
+/** @brief Get protocol currently loaded
+ */
+uint8_t rfidProtocol(void)
+{
+  return currentProtocol;
+}
 
+/** @brief Get CRC register value for the current protocol (CRC enabled)
+ */
+static uint8_t crcPreset(void)
+{
+  switch (currentProtocol) {
+    case MFRC630_PROTO_ISO14443B_106:
+    case MFRC630_PROTO_ISO15693:
+      return 0x7B;                            // CRC16, preset 0xFFFF, inverted
+    case MFRC630_PROTO_FELICA_212:
+      return 0x09;                            // CRC16, preset 0x0000
+    default:
+      return 0x18 | 1;                        // CRC16, preset 0x6363
+  }
 }
 
-void rfidInit() {
-  writeBuffer(MFRC630_REG_DRV_MOD, sizeof(antcfg_iso14443a_106), antcfg_iso14443a_106);
-  write8(MFRC630_REG_DRV_MOD, 0x8E); /* Driver mode register */
-  write8(MFRC630_REG_TX_AMP, 0x12);  /* Transmitter amplifier register */
-  write8(MFRC630_REG_DRV_CON, 0x39); /* Driver configuration register */
-  write8(MFRC630_REG_TXL, 0x06);     /* Transmitter register */
+/** @brief Exchange a frame with the selected card (CRC on TX and RX)
+ *  @param txbuf Frame to send
+ *  @param txlen Length of frame to send
+ *  @param rxbuf Buffer for the response
+ *  @param rxlen Size of response buffer
+ *  @param timeout Frame wait time in T0 ticks (see RFID_DEFAULT_TIMEOUT)
+ *  @return Number of bytes received, or -1 on timeout or error
+ */
+int16_t rfidTransceive(uint8_t *txbuf, uint8_t txlen, uint8_t *rxbuf, uint16_t rxlen, uint16_t timeout)
+{
+  return rfidExchange(txbuf, txlen, rxbuf, rxlen, timeout, NULL);
 }
 
-void rfidLpcdInit(void)
+/** @brief Exchange a frame; see rfidExchange
+ *  @param txCrc false for frames sent without CRC (anticollision)
+ *  @param rxCrc false for responses without CRC (4 bit ACK/NAK, anticollision)
+ */
+static int16_t exchangeFrame(uint8_t *txbuf, uint8_t txlen, uint8_t *rxbuf, uint16_t rxlen, uint16_t timeout, bool txCrc, bool rxCrc, uint8_t *error)
 {
-  // Perform SW reset, then idle
-  rfidSoftReset();
-
-  // LPCD (low power card detect) config
-  write8(MFRC630_REG_LPCD_QMIN, 0xc0);      // Set Qmin register
-  write8(MFRC630_REG_LPCD_QMAX, 0xff);      // Set Qmax register
-  write8(MFRC630_REG_LPCD_IMIN, 0xc0);      // Set Imin register
-  write8(MFRC630_REG_DRV_MOD, 0x89);        // Set DrvMode register
-
-  // Execute trimming procedure
-  write8(MFRC630_REG_T3_RELOAD_HI, 0x00);   // Write default T3 reload value Hi
-  write8(MFRC630_REG_T3_RELOAD_LO, 0x10);   // Write default T3 reload value Lo
-  write8(MFRC630_REG_T4_RELOAD_HI, 0x00);   // Write min. T4 reload value Hi
-  write8(MFRC630_REG_T4_RELOAD_LO, 0x05);   // Write min. T4 reload value Lo
-  write8(MFRC630_REG_T4_CONTROL, 0xf8);     // Config T4 for AutoLPCD & AutoRestart. Set AutoTrimm bit. Start T4.
-  write8(MFRC630_REG_LPCD_Q_RESULT, 0x40);  // Clear LPCD result
-  write8(MFRC630_REG_RCV, 0x52);            // Set Rx_ADCmode bit
-  write8(MFRC630_REG_RX_ANA, 0x03);         // Raise receiver gain to maximum
-  write8(MFRC630_REG_COMMAND, 0x01);        // Execute Rc663 command "Auto_T4" (Low power card detection and/or Auto trimming)
-
-  // Flush CMD and FIFO
-  write8(MFRC630_REG_COMMAND, 0x00);
-  write8(MFRC630_REG_FIFO_CONTROL, 0xb0);
+  uint8_t irqval = 0;
+  uint8_t frameCon = 0;
 
-  // Clear Rx_ADCmode bit
-  write8(MFRC630_REG_RCV, 0x12);
+  if (error != NULL) {
+    *error = 0;
+  }
 
-  // Get window values if not already calculated
-  if ((LPCD_QMin == 0) || (LPCD_QMax == 0) || (LPCD_IMin == 0))
-    getWindowValues();
+  /* Cancel any current command */
+  writeCommand(MFRC630_CMD_IDLE);
 
-  // Set window values
-  write8(MFRC630_REG_LPCD_QMIN, LPCD_QMin);
-  write8(MFRC630_REG_LPCD_QMAX, LPCD_QMax);
-  write8(MFRC630_REG_LPCD_IMIN, LPCD_IMin);
+  /* Flush the FIFO */
+  clearFIFO();
 
-  // Prepare LPCD command; power down time 10 ms, cmd time 150 us
-  write8(MFRC630_REG_T3_RELOAD_HI, 0x07);
-  write8(MFRC630_REG_T3_RELOAD_LO, 0xf2);
-  write8(MFRC630_REG_T4_RELOAD_HI, 0x00);
-  write8(MFRC630_REG_T4_RELOAD_LO, 0x13);
+  /* Enable CRCs, transmit full bytes (or no data at all), no alignment. */
+  write8(MFRC630_REG_TX_CRC_PRESET, txCrc ? crcPreset() : crcPreset() & ~1);
+  write8(MFRC630_REG_RX_CRC_CON, rxCrc ? crcPreset() : crcPreset() & ~1);
+  write8(MFRC630_REG_TX_DATA_NUM, txlen ? 0x08 : 0x00);
+  write8(MFRC630_REG_RX_BIT_CTRL, 0);
 
-  // Configure T4 for AutoLPCD and AutoRestart/Autowakeup. Use 2Khz LFO, Start T4
-  write8(MFRC630_REG_T4_CONTROL, 0xdf);
+  /* No data: send the EOF alone, without the SOF that starts a request */
+  if (txlen == 0) {
+    frameCon = read8(MFRC630_REG_FRAME_CON);
+    write8(MFRC630_REG_FRAME_CON, frameCon & ~MFRC630_FRAME_CON_START_SYM);
+  }
 
-  // Clear LPCD result
-  write8(MFRC630_REG_LPCD_Q_RESULT, 0x40);
+  /* Clear the interrupts. */
+  write8(MFRC630_REG_IRQ0, 0b01111111);
+  write8(MFRC630_REG_IRQ1, 0b00111111);
+  /* Allow the receiver and Error IRQs to be propagated to the GlobalIRQ. */
+  write8(MFRC630_REG_IRQ0EN, MFRC630IRQ0_RXIRQ | MFRC630IRQ0_ERRIRQ);
+  /* Allow Timer0 IRQ to be propagated to the GlobalIRQ. */
+  write8(MFRC630_REG_IRQ1EN, MFRC630IRQ1_TIMER0IRQ);
 
-  // Set Rx_ADCmode bit
-  write8(MFRC630_REG_RCV, 0x52);
+  /* Configure the frame wait timeout using T0. */
+  write8(MFRC630_REG_T0_CONTROL, 0b10001);
+  write8(MFRC630_REG_T0_RELOAD_HI, timeout >> 8);
+  write8(MFRC630_REG_TO_RELOAD_LO, timeout & 0xFF);
+  write8(MFRC630_REG_T0_COUNTER_VAL_HI, timeout >> 8);
+  write8(MFRC630_REG_T0_COUNTER_VAL_LO, timeout & 0xFF);
 
-  // Raise receiver gain to max
-  write8(MFRC630_REG_RX_ANA, 0x03);
+  /* Send the frame. */
+  writeParamCommand(MFRC630_CMD_TRANSCEIVE, txlen, txbuf);
 
-  // Wait until T4 is started
-  while(read8(MFRC630_REG_T4_CONTROL) != 0x9f) {};
+  /* Wait here until we're done reading, get an error, or timeout. */
+  while (!(irqval & MFRC630IRQ1_TIMER0IRQ)) {
+    irqval = read8(MFRC630_REG_IRQ1);
+    /* Check for a global interrupt, which can only be ERR or RX. */
+    if (irqval & MFRC630IRQ1_GLOBALIRQ) {
+      break;
+    }
+  }
 
- // Flush cmd and FIFO. Clear all IRQ flags.
+  /* Cancel the current command (in case we timed out or error occurred). */
   writeCommand(MFRC630_CMD_IDLE);
-  write8(MFRC630_REG_FIFO_CONTROL, 0xb0);
-  write8(MFRC630_REG_IRQ0, 0x7f);
-  write8(MFRC630_REG_IRQ1, 0x7f);
 
-  // Enable IRQ sources: Idle and LPCD
-  write8(MFRC630_REG_IRQ0EN, 0x10);
-  write8(MFRC630_REG_IRQ1EN, 0x60);
+  if (txlen == 0) {
+    write8(MFRC630_REG_FRAME_CON, frameCon);
+  }
+
+  /* Check the RX IRQ, and exit appropriately if it has fired (error). */
+  irqval = read8(MFRC630_REG_IRQ0);
+  if (!(irqval & MFRC630IRQ0_RXIRQ) || (irqval & MFRC630IRQ0_ERRIRQ)) {
+    if (irqval & MFRC630IRQ0_ERRIRQ) {
+      uint8_t err = read8(MFRC630_REG_ERROR);
+      if (error != NULL) {
+        *error = err;
+      }
+      else if (err) {
+        printError(err);
+      }
+    }
+    return -1;
+  }
 
-  // Start RC663 cmd "Low power card detection". Enter PowerDown mode.
-  writeCommand(MFRC630_CMD_LPCD);
+  /* The RX IRQ has fired, so the whole frame is already in the FIFO. */
+  int16_t len = fifoLength();
+  if (len > rxlen) {
+    len = rxlen;
+  }
 
-}
+  return readFIFO(len, rxbuf);
 
-uint16_t iso14443aRequest()
-{
-  return iso14443aCommand(ISO14443_CMD_REQA);
 }
 
-void clearFIFO()
+/** @brief Exchange a frame with the card(s) in the field
+ *  @param txbuf Frame to send
+ *  @param txlen Length of frame to send; 0 sends only an EOF (ISO15693),
+ *         with the start symbol switched off in FRAME_CON for the exchange
+ *  @param rxbuf Buffer for the response
+ *  @param rxlen Size of response buffer
+ *  @param timeout Frame wait time in T0 ticks (see RFID_DEFAULT_TIMEOUT)
+ *  @param error If not NULL; set to the error register on return (0 if the
+ *         exchange succeeded or timed out). Errors are then not printed.
+ *  @return Number of bytes received, or -1 on timeout or error
+ */
+int16_t rfidExchange(uint8_t *txbuf, uint8_t txlen, uint8_t *rxbuf, uint16_t rxlen, uint16_t timeout, uint8_t *error)
 {
-  uint8_t ctrl = read8(MFRC630_REG_FIFO_CONTROL);
-  write8(MFRC630_REG_FIFO_CONTROL, ctrl | (1 << 4));
+  return exchangeFrame(txbuf, txlen, rxbuf, rxlen, timeout, true, true, error);
 }
 
-int16_t readFIFOLen()
+/** @brief Send a frame answered by a 4 bit ACK/NAK (e.g. WRITE)
+ *  @param txbuf Frame to send
+ *  @param txlen Length of frame to send
+ *  @param timeout Frame wait time in T0 ticks (see RFID_DEFAULT_TIMEOUT)
+ *  @return true if the card answered ACK
+ */
+bool rfidTransceiveAck(uint8_t *txbuf, uint8_t txlen, uint16_t timeout)
 {
-  /* Give FIFO a chance to fill up. */
-  /* TODO: Why do we need a delay between reads?!? */
-  halCommonDelayMilliseconds(10);
+  uint8_t ack = 0;
 
-  /* Read the MFRC630_REG_FIFO_LENGTH register */
-  /* In 512 byte mode, the upper two bits are stored in FIFO_CONTROL */
-  uint8_t hi = read8(MFRC630_REG_FIFO_CONTROL);
-  uint8_t lo = read8(MFRC630_REG_FIFO_LENGTH);
-
-  /* Determine len based on FIFO size (255 byte or 512 byte mode) */
-  int16_t l = (hi & 0x80) ? lo : (((hi & 0x3) << 8) | lo);
-
-  emberAfCorePrintln("FIFO contains %d byte(s)", l);
-  return l;
+  if (exchangeFrame(txbuf, txlen, &ack, 1, timeout, true, false, NULL) != 1)
+    return false;
 
+  return (ack & 0x0F) == ISO14443_ACK;
 }
 
-int16_t readFIFO(uint16_t len, uint8_t *buffer)
+/** @brief Anticollision at cascade level 1, without selecting the card
+ *  @param uid Set to the 4 UID bytes of cascade level 1 (cascade tag and
+ *         the first 3 bytes for 7 and 10 byte UIDs)
+ *  @return true if exactly one card answered, with a valid BCC
+ *  @note Call after REQA/WUPA; the card stays in READY state
+ */
+bool iso14443aAnticollision(uint8_t *uid)
 {
-  int16_t ctr = 0;
+  uint8_t req[2] = { ISO14443_CAS_LEVEL_1, 0x20 };
+  uint8_t resp[5];                            /* UID CL1 + BCC */
+  uint8_t error;
 
-  /* Check for 512 byte overflow */
-  if (len > 512) {
-    return -1;
-  }
+  if (exchangeFrame(req, sizeof(req), resp, sizeof(resp), RFID_DEFAULT_TIMEOUT, false, false, &error) != sizeof(resp))
+    return false;
 
-  /* Read len bytes from the FIFO */
-  for (uint16_t i=0; i<len; i++) {
-    buffer[i] = read8(MFRC630_REG_FIFO_DATA);
-    ctr++;
-  }
-
-  return ctr;
+  if ((resp[0] ^ resp[1] ^ resp[2] ^ resp[3]) != resp[4])
+    return false;
 
+  memcpy(uid, resp, 4);
+  return true;
 }
 
-int16_t writeFIFO(uint16_t len, uint8_t *buffer)
+uint16_t iso14443aCommand(uint8_t cmd)
 {
-  int counter = 0;
-
-  /* Check for 512 byte overflow */
-  if (len > 512) {
-    return -1;
-  }
-
-  /* Write len bytes to the FIFO */
-  for (uint16_t i = 0; i < len; i++) {
-    write8(MFRC630_REG_FIFO_DATA, buffer[i]);
-    counter++;
-  }
-
-  return counter;
-
+  return iso14443aCommandTimeout(cmd, RFID_DEFAULT_TIMEOUT);
 }
 
-uint16_t iso14443aCommand(uint8_t cmd)
+/** @brief Send REQA or WUPA and wait for the ATQA
+ *  @param cmd ISO14443_CMD_REQA or ISO14443_CMD_WUPA
+ *  @param timeout Frame wait time in T0 ticks
+ *  @return ATQA, 0 if no card answered
+ */
+uint16_t iso14443aCommandTimeout(uint8_t cmd, uint16_t timeout)
 {
   uint16_t atqa = 0; /* Answer to request (2 bytes). */
   uint8_t irqval = 0;
@@ -466,18 +533,17 @@ uint16_t iso14443aCommand(uint8_t cmd)
   /* Allow Timer0 IRQ to be propagated to the GlobalIRQ. */
   write8(MFRC630_REG_IRQ1EN, MFRC630IRQ1_TIMER0IRQ);
 
-  /* Configure the frame wait timeout using T0 (5ms max). */
+  /* Configure the frame wait timeout using T0. */
   write8(MFRC630_REG_T0_CONTROL, 0b10001);
-  write8(MFRC630_REG_T0_RELOAD_HI, 1100 >> 8);
-  write8(MFRC630_REG_TO_RELOAD_LO, 0xFF);
-  write8(MFRC630_REG_T0_COUNTER_VAL_HI, 1100 >> 8);
-  write8(MFRC630_REG_T0_COUNTER_VAL_LO, 0xFF);
+  write8(MFRC630_REG_T0_RELOAD_HI, timeout >> 8);
+  write8(MFRC630_REG_TO_RELOAD_LO, timeout & 0xFF);
+  write8(MFRC630_REG_T0_COUNTER_VAL_HI, timeout >> 8);
+  write8(MFRC630_REG_T0_COUNTER_VAL_LO, timeout & 0xFF);
 
   /* Send the ISO14443 command. */
   writeParamCommand(MFRC630_CMD_TRANSCEIVE, 1, &cmd);
 
   /* Wait here until we're done reading, get an error, or timeout. */
-  /* TODO: Update to use timeout parameter! */
   while (!(irqval & MFRC630IRQ1_TIMER0IRQ)) {
     irqval = read8(MFRC630_REG_IRQ1);
     /* Check for a global interrupt, which can only be ERR or RX. */
@@ -506,7 +572,7 @@ uint16_t iso14443aCommand(uint8_t cmd)
   }
 
   /* Read the response */
-  uint16_t rxlen = readFIFOLen();
+  uint16_t rxlen = fifoLength();
   if (rxlen == 2) {
     /*
      * If we have 2 bytes for the response, it's the ATQA.
@@ -651,7 +717,7 @@ uint8_t iso14443aSelect(uint8_t *uid, uint8_t *sak)
       }
 
       /* Read the UID so far */
-      uint16_t rxlen = readFIFOLen();
+      uint16_t rxlen = fifoLength();
       uint8_t buf[5]; /* UID = 4 bytes + BCC */
       readFIFO(rxlen < 5 ? rxlen : 5, buf);
 
@@ -724,7 +790,7 @@ uint8_t iso14443aSelect(uint8_t *uid, uint8_t *sak)
     }
 
     /* Read SAK answer from fifo. */
-    uint8_t sak_len = readFIFOLen();
+    uint8_t sak_len = fifoLength();
     if (sak_len != 1) {
         emberAfCorePrintln("ERROR: NO SAK in response!");
       return 0;
@@ -742,6 +808,8 @@ uint8_t iso14443aSelect(uint8_t *uid, uint8_t *sak)
       }
     } else {
       /* Done! */
+      *sak = sak_value;
+
       /* Add current bytes at this level to the UID. */
       uint8_t UIDn;
       for (UIDn = 0; UIDn < 4; UIDn++) {
@@ -796,20 +864,33 @@ bool readRfidTag(rfid_tag_t* rfid_tag)
 {
   uint16_t atqa = iso14443aRequest();
 
-  if (atqa) {
-    uint8_t uid[10] = { 0 };
-    uint8_t len;
-    uint8_t sak;
+  if (atqa)
+    return readRfidTagSelect(rfid_tag, atqa);
 
-    len = iso14443aSelect(uid, &sak);
+  return false;
 
-    if (len >= 4 && len <= 10) {
-      memcpy(rfid_tag->rfid, uid, len);
-      rfid_tag->size = len;
-      rfid_tag->sak = sak;
-      return true;
-    }
+}
 
+/** @brief Run anticollision/select on a card that has answered REQA or WUPA
+ *  @param rfid_tag Tag; filled in on success
+ *  @param atqa ATQA the card answered with
+ *  @return true if the card was selected
+ */
+bool readRfidTagSelect(rfid_tag_t* rfid_tag, const uint16_t atqa)
+{
+  uint8_t uid[10] = { 0 };
+  uint8_t len;
+  uint8_t sak;
+
+  len = iso14443aSelect(uid, &sak);
+
+  if (len >= 4 && len <= 10) {
+    memcpy(rfid_tag->rfid, uid, len);
+    rfid_tag->size = len;
+    rfid_tag->sak = sak;
+    rfid_tag->atqa = atqa;
+    rfid_tag->protocol = MFRC630_PROTO_ISO14443A_106;
+    return true;
   }
 
   return false;
@@ -835,7 +916,7 @@ uint8_t readEeprom(const uint8_t page, const uint8_t offset, const uint8_t lengt
   halCommonDelayMilliseconds(10);
 
   // Check length
-  uint16_t res = readFIFOLen();
+  uint16_t res = fifoLength();
 
   if (res != length) {
     uint8_t error = read8(MFRC630_REG_ERROR);
@@ -14,6 +14,15 @@
 
 #include "app/framework/include/af.h"
 
+/*! FIFO size in 255 byte mode (selected by rfidSoftReset) */
+#define RFID_FIFO_SIZE          255
+
+/*! Default frame wait time in T0 ticks (1 tick = 4.72 us, 1100 = 5.2 ms) */
+#define RFID_DEFAULT_TIMEOUT    1100
+
+/*! 4 bit ACK to WRITE and value commands; anything else is a NAK */
+#define ISO14443_ACK            0x0A
+
 /********************
  * REGISTER SECTION *
  *******************/
@@ -123,6 +132,7 @@ enum mfrc630cmd {
 enum iso14443_cmd {
   ISO14443_CMD_REQA = 0x26,               /**< Request command. */
   ISO14443_CMD_WUPA = 0x52,               /**< Wakeup command. */
+  ISO14443_CMD_HLTA = 0x50,               /**< Halt command. */
   ISO14443_CAS_LEVEL_1 = 0x93,            /**< Anticollision cascade level 1. */
   ISO14443_CAS_LEVEL_2 = 0x95,            /**< Anticollision cascade level 2. */
   ISO14443_CAS_LEVEL_3 = 0x97             /**< Anticollision cascade level 3. */
@@ -143,7 +153,10 @@ enum mifare_cmd {
 
 /*! NTAG Commands */
 enum ntag_cmd {
+  NTAG_CMD_GET_VERSION = 0x60,            /**< NTAG/Ultralight EV1 product version. */
   NTAG_CMD_READ = 0x30,                   /**> NTAG page read. */
+  NTAG_CMD_FAST_READ = 0x3A,              /**< NTAG/Ultralight EV1 page range read. */
+  NTAG_CMD_READ_SIG = 0x3C,               /**< NTAG/Ultralight EV1 originality signature. */
   NTAG_CMD_WRITE = 0xA2,                  /**< NTAG-specfiic 4 byte write. */
   NTAG_CMD_COMP_WRITE = 0xA0              /**< Mifare Classic 16-byte compat. write. */
 };
@@ -158,6 +171,14 @@ enum mfrc630comstat {
   MFRC630_COMSTAT_RECEIVING = 0b111       /**< Receiving */
 };
 
+/*! LOADPROTOCOL protocol numbers (see Table 7.10.2.12: Predefined protocol overview) */
+enum mfrc630protocol {
+  MFRC630_PROTO_ISO14443A_106 = 0x00,     /**< ISO14443A 106 kbit/s */
+  MFRC630_PROTO_ISO14443B_106 = 0x04,     /**< ISO14443B 106 kbit/s */
+  MFRC630_PROTO_FELICA_212 = 0x08,        /**< FeliCa 212 kbit/s */
+  MFRC630_PROTO_ISO15693 = 0x0A           /**< ISO15693 SLI 1/4 SSC 26 kbit/s */
+};
+
 /*! Radio config modes */
 enum mfrc630radiocfg {
   MFRC630_RADIOCFG_ISO1443A_106 = 1,      /**< ISO1443A 106 Mode */
@@ -200,6 +221,16 @@ enum mfrc630irq1 {
   MFRC630IRQ1_TIMER0IRQ = (1 << 0),       /**< Timer 0 underflow */
 };
 
+/*! MFRC630_REG_DRV_MOD bits */
+enum mfrc630drvmod {
+  MFRC630_DRV_MOD_TXEN = (1 << 3)         /**< Transmitter (RF field) on */
+};
+
+/*! MFRC630_REG_FRAME_CON bits */
+enum mfrc630framecon {
+  MFRC630_FRAME_CON_START_SYM = 0x03      /**< TX start symbol (ISO15693 SOF); 0 = none */
+};
+
 /*! MFRC630 crypto engine status */
 enum mfrc630status {
   MFRC630STATUS_CRYPTO1ON = (1 << 5) /**< Mifare Classic Crypto engine on */
@@ -209,10 +240,19 @@ typedef struct {
   uint8_t size;
   uint8_t rfid[10];
   uint8_t sak;
+  uint16_t atqa;                          /**< ISO14443A only; 0 for other protocols */
+  uint8_t protocol;                       /**< MFRC630_PROTO_* the tag answered on */
 } rfid_tag_t;
 
+/*! Transmitter and receiver settings written by rfidInit (ISO14443A 106) */
+typedef struct {
+  uint8_t txAmp;                          /**< TX_AMP: CW amplitude and residual carrier */
+  uint8_t drvCon;                         /**< DRV_CON: incl. CwMax */
+  uint8_t rxThreshold;                    /**< RX_THRESHOLD: MinLevel and MinLevelP */
+  uint8_t rxAna;                          /**< RX_ANA: high pass corner and gain */
+} rfid_antenna_t;
+
 //void rfidHardReset();
-void printQIValues(void);
 void rfidSoftReset();
 void writeCommand(uint8_t command);
 void writeParamCommand(uint8_t command, uint8_t paramlen, uint8_t *params);
@@ -220,15 +260,25 @@ void writeBuffer(uint8_t reg, uint16_t len, uint8_t *buf);
 void write8(uint8_t reg, uint8_t value);
 uint8_t read8(uint8_t reg);
 void rfidInit();
-void rfidLpcdInit();
-void rfidLpcdInitHPG();
+void rfidSetAntenna(const rfid_antenna_t *antenna);
+const rfid_antenna_t *rfidAntenna(void);
+const rfid_antenna_t *rfidDefaultAntenna(void);
 void clearFIFO();
-int16_t readFIFOLen();
 int16_t readFIFO(uint16_t len, uint8_t *buffer);
 int16_t writeFIFO(uint16_t len, uint8_t *buffer);
+void rfidFieldOff(void);
+bool rfidLoadProtocol(uint8_t protocol);
+uint8_t rfidProtocol(void);
+bool rfidCommand(uint8_t command, uint8_t paramlen, uint8_t *params, uint16_t timeout);
+int16_t rfidTransceive(uint8_t *txbuf, uint8_t txlen, uint8_t *rxbuf, uint16_t rxlen, uint16_t timeout);
+int16_t rfidExchange(uint8_t *txbuf, uint8_t txlen, uint8_t *rxbuf, uint16_t rxlen, uint16_t timeout, uint8_t *error);
+bool rfidTransceiveAck(uint8_t *txbuf, uint8_t txlen, uint16_t timeout);
 
 uint16_t iso14443aRequest();
 uint16_t iso14443aCommand(uint8_t cmd);
+uint16_t iso14443aCommandTimeout(uint8_t cmd, uint16_t timeout);
+bool iso14443aAnticollision(uint8_t *uid);
+bool iso14443aHalt(void);
 uint8_t iso14443aSelect(uint8_t *uid, uint8_t *sak);
 
 uint8_t readEeprom(uint8_t page, uint8_t offset, uint8_t length, uint8_t* buffer);
@@ -236,5 +286,6 @@ uint8_t readEeprom(uint8_t page, uint8_t offset, uint8_t length, uint8_t* buffer
 void printError(uint8_t err);
 
 bool readRfidTag(rfid_tag_t *rfid_tag);
+bool readRfidTagSelect(rfid_tag_t *rfid_tag, uint16_t atqa);
 
 #endif //__RFID_H__
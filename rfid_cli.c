@@ -0,0 +1,369 @@
+/*
+ * rfid_cli.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "rfid_cli.h"
+
+#include "app/framework/include/af.h"
+
+#include "sl_cli.h"
+#include "sl_cli_handles.h"
+
+#include "cache.h"
+#include "dedup.h"
+#include "duty.h"
+#include "encode.h"
+#include "energy.h"
+#include "field.h"
+#include "lpcd.h"
+#include "mifare.h"
+#include "originality.h"
+#include "poll.h"
+#include "rfid_config.h"
+#include "rfid_crypto.h"
+#include "tune.h"
+
+/** @brief Store a MIFARE key in the reader EEPROM
+ *  @note rfid store-key <keyNo> {<6 byte key>}
+ */
+static void storeKeyCommand(sl_cli_command_arg_t *arguments)
+{
+  size_t len;
+  uint8_t keyNo = sl_cli_get_argument_uint8(arguments, 0);
+  uint8_t *key = sl_cli_get_argument_hex(arguments, 1, &len);
+
+  if (len != MIFARE_KEY_SIZE) {
+    emberAfCorePrintln("key must be %d bytes", MIFARE_KEY_SIZE);
+    return;
+  }
+
+  emberAfCorePrintln("store key %d: %s", keyNo, mifareStoreKey(keyNo, key) ? "ok" : "failed");
+}
+
+/** @brief Print protocol poll order and hit counts
+ *  @note rfid poll-stats
+ */
+static void pollStatsCommand(sl_cli_command_arg_t *arguments)
+{
+  (void)arguments;
+  pollPrintStats();
+}
+
+#if RFID_ORIGINALITY_CHECK
+/** @brief Print originality check cache hit rate and verify time
+ *  @note rfid orig-stats
+ */
+static void originalityStatsCommand(sl_cli_command_arg_t *arguments)
+{
+  (void)arguments;
+  originalityPrintStats();
+}
+#endif
+
+/** @brief Print duplicate suppression counters
+ *  @note rfid dedup-stats
+ */
+static void dedupStatsCommand(sl_cli_command_arg_t *arguments)
+{
+  (void)arguments;
+  dedupPrintStats();
+}
+
+/** @brief Load part of the NDEF image for encoding mode
+ *  @note rfid encode-load <offset> {<data>}
+ */
+static void encodeLoadCommand(sl_cli_command_arg_t *arguments)
+{
+  size_t len;
+  uint16_t offset = sl_cli_get_argument_uint16(arguments, 0);
+  uint8_t *data = sl_cli_get_argument_hex(arguments, 1, &len);
+
+  emberAfCorePrintln("encode load: %s", encodeLoad(offset, data, len) ? "ok" : "does not fit");
+}
+
+/** @brief Start encoding every tag that arrives
+ *  @note rfid encode-start <length> <lock>
+ */
+static void encodeStartCommand(sl_cli_command_arg_t *arguments)
+{
+  uint16_t len = sl_cli_get_argument_uint16(arguments, 0);
+  bool lock = (sl_cli_get_argument_uint8(arguments, 1) != 0);
+
+  emberAfCorePrintln("encode start: %s", encodeStart(len, lock) ? "ok" : "invalid length");
+}
+
+/** @brief Leave encoding mode
+ *  @note rfid encode-stop
+ */
+static void encodeStopCommand(sl_cli_command_arg_t *arguments)
+{
+  (void)arguments;
+  encodeStop();
+}
+
+/** @brief Print content cache hit/miss counters
+ *  @note rfid cache-stats
+ */
+static void cacheStatsCommand(sl_cli_command_arg_t *arguments)
+{
+  (void)arguments;
+  cachePrintStats();
+}
+
+/** @brief Drop all cached tag payloads
+ *  @note rfid cache-clear
+ */
+static void cacheClearCommand(sl_cli_command_arg_t *arguments)
+{
+  (void)arguments;
+  cacheClear();
+  emberAfCorePrintln("cache cleared");
+}
+
+/** @brief Print LPCD baseline and false wake counters
+ *  @note rfid lpcd-stats
+ */
+static void lpcdStatsCommand(sl_cli_command_arg_t *arguments)
+{
+  (void)arguments;
+  lpcdPrintStats();
+}
+
+/** @brief Drop the stored LPCD calibration and calibrate again
+ *  @note rfid lpcd-recal
+ *  @note Run with no card in the field, the new window is calculated right away
+ */
+static void lpcdRecalCommand(sl_cli_command_arg_t *arguments)
+{
+  (void)arguments;
+  lpcdRecalibrate();
+  lpcdInit();
+}
+
+/** @brief Sweep the antenna and receiver settings against a reference card
+ *  @note rfid tune (reference card in the field)
+ */
+static void tuneCommand(sl_cli_command_arg_t *arguments)
+{
+  (void)arguments;
+  fieldBegin();
+  tuneRun();
+  fieldEnd();
+  lpcdInit();
+}
+
+/** @brief Drop the stored antenna profile and use the board defaults
+ *  @note rfid tune-clear
+ */
+static void tuneClearCommand(sl_cli_command_arg_t *arguments)
+{
+  (void)arguments;
+  tuneClear();
+  emberAfCorePrintln("tune: board defaults");
+}
+
+/** @brief Print the LPCD power-down period and re-arm counters
+ *  @note rfid duty-stats
+ */
+static void dutyStatsCommand(sl_cli_command_arg_t *arguments)
+{
+  (void)arguments;
+  dutyPrintStats();
+}
+
+/** @brief Set the time of day for the LPCD busy hours
+ *  @note rfid set-clock <hour> <minute>
+ */
+static void setClockCommand(sl_cli_command_arg_t *arguments)
+{
+  uint8_t hour = sl_cli_get_argument_uint8(arguments, 0);
+  uint8_t minute = sl_cli_get_argument_uint8(arguments, 1);
+
+  if ((hour > 23) || (minute > 59)) {
+    emberAfCorePrintln("invalid time");
+    return;
+  }
+
+  dutySetClock(hour, minute);
+  emberAfCorePrintln("clock set to %d:%d", hour, minute);
+}
+
+/** @brief Print energy mode residency, phase times and the charge estimate
+ *  @note rfid energy-stats
+ */
+static void energyStatsCommand(sl_cli_command_arg_t *arguments)
+{
+  (void)arguments;
+  energyPrintStats();
+}
+
+/** @brief Store an AES card key (e.g. DESFire master key) in the PSA key store
+ *  @note rfid store-aes-key <keyNo> {<16 byte key>}
+ */
+static void storeAesKeyCommand(sl_cli_command_arg_t *arguments)
+{
+  size_t len;
+  uint8_t keyNo = sl_cli_get_argument_uint8(arguments, 0);
+  uint8_t *key = sl_cli_get_argument_hex(arguments, 1, &len);
+
+  if ((len != RFID_AES_KEY_SIZE) || (keyNo >= RFID_KEYS)) {
+    emberAfCorePrintln("key must be %d bytes, key number < %d", RFID_AES_KEY_SIZE, RFID_KEYS);
+    return;
+  }
+
+  bool ok = (rfidCryptoImportAesKey(key, RFID_KEY_ID(keyNo)) != 0);
+  memset(key, 0, len);
+
+  emberAfCorePrintln("store aes key %d: %s", keyNo, ok ? "ok" : "failed");
+}
+
+static const sl_cli_command_info_t cli_cmd_rfid_store_key = \
+  SL_CLI_COMMAND(storeKeyCommand,
+                 "Store a MIFARE key in the reader EEPROM.",
+                 "key number" SL_CLI_UNIT_SEPARATOR "key" SL_CLI_UNIT_SEPARATOR,
+                 {SL_CLI_ARG_UINT8, SL_CLI_ARG_HEX, SL_CLI_ARG_END, });
+
+static const sl_cli_command_info_t cli_cmd_rfid_store_aes_key = \
+  SL_CLI_COMMAND(storeAesKeyCommand,
+                 "Store an AES card key in the PSA key store.",
+                 "key number" SL_CLI_UNIT_SEPARATOR "key" SL_CLI_UNIT_SEPARATOR,
+                 {SL_CLI_ARG_UINT8, SL_CLI_ARG_HEX, SL_CLI_ARG_END, });
+
+static const sl_cli_command_info_t cli_cmd_rfid_poll_stats = \
+  SL_CLI_COMMAND(pollStatsCommand,
+                 "Print protocol poll order and hit counts.",
+                 "",
+                 {SL_CLI_ARG_END, });
+
+#if RFID_ORIGINALITY_CHECK
+static const sl_cli_command_info_t cli_cmd_rfid_orig_stats = \
+  SL_CLI_COMMAND(originalityStatsCommand,
+                 "Print originality check cache hits and verify time.",
+                 "",
+                 {SL_CLI_ARG_END, });
+#endif
+
+static const sl_cli_command_info_t cli_cmd_rfid_dedup_stats = \
+  SL_CLI_COMMAND(dedupStatsCommand,
+                 "Print duplicate read suppression counters.",
+                 "",
+                 {SL_CLI_ARG_END, });
+
+static const sl_cli_command_info_t cli_cmd_rfid_encode_load = \
+  SL_CLI_COMMAND(encodeLoadCommand,
+                 "Load part of the NDEF image to encode (offset 0 = page 4).",
+                 "offset" SL_CLI_UNIT_SEPARATOR "data" SL_CLI_UNIT_SEPARATOR,
+                 {SL_CLI_ARG_UINT16, SL_CLI_ARG_HEX, SL_CLI_ARG_END, });
+
+static const sl_cli_command_info_t cli_cmd_rfid_encode_start = \
+  SL_CLI_COMMAND(encodeStartCommand,
+                 "Encode every NTAG that arrives with the loaded image.",
+                 "image length" SL_CLI_UNIT_SEPARATOR "lock (0/1)" SL_CLI_UNIT_SEPARATOR,
+                 {SL_CLI_ARG_UINT16, SL_CLI_ARG_UINT8, SL_CLI_ARG_END, });
+
+static const sl_cli_command_info_t cli_cmd_rfid_encode_stop = \
+  SL_CLI_COMMAND(encodeStopCommand,
+                 "Leave encoding mode.",
+                 "",
+                 {SL_CLI_ARG_END, });
+
+static const sl_cli_command_info_t cli_cmd_rfid_cache_stats = \
+  SL_CLI_COMMAND(cacheStatsCommand,
+                 "Print tag content cache hits and misses.",
+                 "",
+                 {SL_CLI_ARG_END, });
+
+static const sl_cli_command_info_t cli_cmd_rfid_cache_clear = \
+  SL_CLI_COMMAND(cacheClearCommand,
+                 "Drop all cached tag payloads.",
+                 "",
+                 {SL_CLI_ARG_END, });
+
+static const sl_cli_command_info_t cli_cmd_rfid_lpcd_stats = \
+  SL_CLI_COMMAND(lpcdStatsCommand,
+                 "Print LPCD baseline and false wake counters.",
+                 "",
+                 {SL_CLI_ARG_END, });
+
+static const sl_cli_command_info_t cli_cmd_rfid_lpcd_recal = \
+  SL_CLI_COMMAND(lpcdRecalCommand,
+                 "Drop the stored LPCD window and calibrate again (no card in the field).",
+                 "",
+                 {SL_CLI_ARG_END, });
+
+static const sl_cli_command_info_t cli_cmd_rfid_tune = \
+  SL_CLI_COMMAND(tuneCommand,
+                 "Find and store the lowest field power that reads the reference card in the field.",
+                 "",
+                 {SL_CLI_ARG_END, });
+
+static const sl_cli_command_info_t cli_cmd_rfid_tune_clear = \
+  SL_CLI_COMMAND(tuneClearCommand,
+                 "Drop the stored antenna profile and use the board defaults.",
+                 "",
+                 {SL_CLI_ARG_END, });
+
+static const sl_cli_command_info_t cli_cmd_rfid_duty_stats = \
+  SL_CLI_COMMAND(dutyStatsCommand,
+                 "Print the LPCD power-down period and re-arm counters.",
+                 "",
+                 {SL_CLI_ARG_END, });
+
+static const sl_cli_command_info_t cli_cmd_rfid_set_clock = \
+  SL_CLI_COMMAND(setClockCommand,
+                 "Set the time of day used for the LPCD busy hours.",
+                 "hour" SL_CLI_UNIT_SEPARATOR "minute" SL_CLI_UNIT_SEPARATOR,
+                 {SL_CLI_ARG_UINT8, SL_CLI_ARG_UINT8, SL_CLI_ARG_END, });
+
+static const sl_cli_command_info_t cli_cmd_rfid_energy_stats = \
+  SL_CLI_COMMAND(energyStatsCommand,
+                 "Print energy mode residency, phase times and the charge estimate.",
+                 "",
+                 {SL_CLI_ARG_END, });
+
+static const sl_cli_command_entry_t rfid_group_table[] = {
+  { "store-key", &cli_cmd_rfid_store_key, false },
+  { "store-aes-key", &cli_cmd_rfid_store_aes_key, false },
+  { "poll-stats", &cli_cmd_rfid_poll_stats, false },
+#if RFID_ORIGINALITY_CHECK
+  { "orig-stats", &cli_cmd_rfid_orig_stats, false },
+#endif
+  { "dedup-stats", &cli_cmd_rfid_dedup_stats, false },
+  { "cache-stats", &cli_cmd_rfid_cache_stats, false },
+  { "cache-clear", &cli_cmd_rfid_cache_clear, false },
+  { "lpcd-stats", &cli_cmd_rfid_lpcd_stats, false },
+  { "lpcd-recal", &cli_cmd_rfid_lpcd_recal, false },
+  { "tune", &cli_cmd_rfid_tune, false },
+  { "tune-clear", &cli_cmd_rfid_tune_clear, false },
+  { "duty-stats", &cli_cmd_rfid_duty_stats, false },
+  { "set-clock", &cli_cmd_rfid_set_clock, false },
+  { "energy-stats", &cli_cmd_rfid_energy_stats, false },
+  { "encode-load", &cli_cmd_rfid_encode_load, false },
+  { "encode-start", &cli_cmd_rfid_encode_start, false },
+  { "encode-stop", &cli_cmd_rfid_encode_stop, false },
+  { NULL, NULL, false },
+};
+
+static const sl_cli_command_info_t cli_cmd_grp_rfid = \
+  SL_CLI_COMMAND_GROUP(rfid_group_table, "RFID reader commands");
+
+static const sl_cli_command_entry_t rfid_cli_table[] = {
+  { "rfid", &cli_cmd_grp_rfid, false },
+  { NULL, NULL, false },
+};
+
+static sl_cli_command_group_t rfid_cli_group = {
+  { NULL },
+  false,
+  rfid_cli_table
+};
+
+/** @brief Register RFID commands with the CLI
+ */
+void rfidCliInit(void)
+{
+  sl_cli_command_add_command_group(sl_cli_example_handle, &rfid_cli_group);
+}
@@ -0,0 +1,13 @@
+/*
+ * rfid_cli.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef RFID_CLI_H_
+#define RFID_CLI_H_
+
+void rfidCliInit(void);
+
+#endif /* RFID_CLI_H_ */
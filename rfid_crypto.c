@@ -0,0 +1,150 @@
+/*
+ * rfid_crypto.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "rfid_crypto.h"
+
+#include "em_device.h"
+#include "mbedtls/platform_util.h"
+
+/*
+ * Keys are kept in the Secure Engine (wrapped) on parts with Secure Vault
+ * High. Other parts keep them in the PSA key store; in both cases the
+ * application only ever holds key IDs.
+ */
+#if defined(SEMAILBOX_PRESENT) && (_SILICON_LABS_SECURITY_FEATURE == _SILICON_LABS_SECURITY_FEATURE_VAULT)
+#include "sli_se_opaque_types.h"
+#define RFID_KEY_LOCATION         PSA_KEY_LOCATION_SLI_SE_OPAQUE
+#else
+#define RFID_KEY_LOCATION         PSA_KEY_LOCATION_LOCAL_STORAGE
+#endif
+
+/** @brief Initialize PSA crypto
+ */
+bool rfidCryptoInit(void)
+{
+  return psa_crypto_init() == PSA_SUCCESS;
+}
+
+/** @brief Import an AES-128 key usable for CBC and CMAC
+ *  @param key Key material
+ *  @param id Persistent key ID, or 0 for a volatile key
+ *  @return Key ID, or 0 on error
+ *  @note Keys are not exportable
+ */
+psa_key_id_t rfidCryptoImportAesKey(const uint8_t *key, const psa_key_id_t id)
+{
+  psa_key_attributes_t attr = PSA_KEY_ATTRIBUTES_INIT;
+  psa_key_id_t keyId = 0;
+
+  psa_set_key_type(&attr, PSA_KEY_TYPE_AES);
+  psa_set_key_bits(&attr, RFID_AES_KEY_SIZE * 8);
+  psa_set_key_usage_flags(&attr, PSA_KEY_USAGE_ENCRYPT | PSA_KEY_USAGE_DECRYPT | PSA_KEY_USAGE_SIGN_MESSAGE | PSA_KEY_USAGE_VERIFY_MESSAGE);
+  psa_set_key_algorithm(&attr, PSA_ALG_CBC_NO_PADDING);
+  psa_set_key_enrollment_algorithm(&attr, PSA_ALG_CMAC);
+
+  if (id != 0) {
+    psa_set_key_lifetime(&attr, PSA_KEY_LIFETIME_FROM_PERSISTENCE_AND_LOCATION(PSA_KEY_PERSISTENCE_DEFAULT, RFID_KEY_LOCATION));
+    psa_set_key_id(&attr, id);
+    psa_destroy_key(id);
+  }
+  else {
+    psa_set_key_lifetime(&attr, PSA_KEY_LIFETIME_FROM_PERSISTENCE_AND_LOCATION(PSA_KEY_PERSISTENCE_VOLATILE, RFID_KEY_LOCATION));
+  }
+
+  if (psa_import_key(&attr, key, RFID_AES_KEY_SIZE, &keyId) != PSA_SUCCESS) {
+    emberAfCorePrintln("ERROR: failed to import key");
+    keyId = 0;
+  }
+
+  psa_reset_key_attributes(&attr);
+  return keyId;
+
+}
+
+/** @brief Derive a volatile AES-128 key as CMAC(key, input)
+ *  @param key Key ID
+ *  @param input Derivation data
+ *  @param len Length of derivation data
+ *  @return Key ID of derived key, or 0 on error
+ *  @note Used for key diversification (AN10922) and session keys. The CMAC
+ *        only lives on the stack until it is imported.
+ */
+psa_key_id_t rfidCryptoDeriveKey(const psa_key_id_t key, const uint8_t *input, const uint16_t len)
+{
+  uint8_t derived[RFID_AES_KEY_SIZE];
+  psa_key_id_t keyId = 0;
+
+  if (rfidCryptoCmac(key, input, len, derived))
+    keyId = rfidCryptoImportAesKey(derived, 0);
+
+  mbedtls_platform_zeroize(derived, sizeof(derived));
+  return keyId;
+}
+
+/** @brief Destroy a key and clear the key ID
+ */
+void rfidCryptoDestroyKey(psa_key_id_t *key)
+{
+  if (*key != 0) {
+    psa_destroy_key(*key);
+    *key = 0;
+  }
+}
+
+/** @brief AES-128 CBC encrypt or decrypt (no padding)
+ *  @param key Key ID
+ *  @param encrypt true to encrypt, false to decrypt
+ *  @param iv 16 byte IV, or NULL for all zeros
+ *  @param input Input data (multiple of 16 bytes)
+ *  @param len Length of input data
+ *  @param output Output buffer (len bytes); may be the same as input
+ *  @return true on success
+ */
+bool rfidCryptoAesCbc(const psa_key_id_t key, const bool encrypt, const uint8_t *iv, const uint8_t *input, const uint16_t len, uint8_t *output)
+{
+  static const uint8_t zeroIv[RFID_AES_BLOCK_SIZE] = { 0 };
+  psa_cipher_operation_t op = PSA_CIPHER_OPERATION_INIT;
+  size_t olen, flen;
+  psa_status_t status;
+
+  if (len % RFID_AES_BLOCK_SIZE)
+    return false;
+
+  if (encrypt)
+    status = psa_cipher_encrypt_setup(&op, key, PSA_ALG_CBC_NO_PADDING);
+  else
+    status = psa_cipher_decrypt_setup(&op, key, PSA_ALG_CBC_NO_PADDING);
+
+  if (status == PSA_SUCCESS)
+    status = psa_cipher_set_iv(&op, iv ? iv : zeroIv, RFID_AES_BLOCK_SIZE);
+  if (status == PSA_SUCCESS)
+    status = psa_cipher_update(&op, input, len, output, len, &olen);
+  if (status == PSA_SUCCESS)
+    status = psa_cipher_finish(&op, &output[olen], len - olen, &flen);
+
+  if (status != PSA_SUCCESS) {
+    psa_cipher_abort(&op);
+    emberAfCorePrintln("ERROR: AES-CBC failed (%d)", status);
+    return false;
+  }
+
+  return true;
+
+}
+
+/** @brief AES-128 CMAC
+ *  @param key Key ID
+ *  @param input Input data
+ *  @param len Length of input data
+ *  @param mac Buffer for the 16 byte MAC
+ *  @return true on success
+ */
+bool rfidCryptoCmac(const psa_key_id_t key, const uint8_t *input, const uint16_t len, uint8_t *mac)
+{
+  size_t olen;
+  return (psa_mac_compute(key, PSA_ALG_CMAC, input, len, mac, RFID_AES_BLOCK_SIZE, &olen) == PSA_SUCCESS) && (olen == RFID_AES_BLOCK_SIZE);
+}
@@ -0,0 +1,30 @@
+/*
+ * rfid_crypto.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef RFID_CRYPTO_H_
+#define RFID_CRYPTO_H_
+
+#include "app/framework/include/af.h"
+
+#include "psa/crypto.h"
+
+#define RFID_AES_BLOCK_SIZE       16
+#define RFID_AES_KEY_SIZE         16
+
+/*! Persistent card keys (stored in PSA ITS) */
+#define RFID_KEY_ID_BASE          (PSA_KEY_ID_USER_MIN + 0x5200)
+#define RFID_KEY_ID(n)            (RFID_KEY_ID_BASE + (n))
+#define RFID_KEYS                 8
+
+bool rfidCryptoInit(void);
+psa_key_id_t rfidCryptoImportAesKey(const uint8_t *key, psa_key_id_t id);
+psa_key_id_t rfidCryptoDeriveKey(psa_key_id_t key, const uint8_t *input, uint16_t len);
+void rfidCryptoDestroyKey(psa_key_id_t *key);
+bool rfidCryptoAesCbc(psa_key_id_t key, bool encrypt, const uint8_t *iv, const uint8_t *input, uint16_t len, uint8_t *output);
+bool rfidCryptoCmac(psa_key_id_t key, const uint8_t *input, uint16_t len, uint8_t *mac);
+
+#endif /* RFID_CRYPTO_H_ */
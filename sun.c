@@ -0,0 +1,251 @@
+/*
+ * sun.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "sun.h"
+
+#include "mbedtls/platform_util.h"
+
+#include "rfid_config.h"
+#include "rfid_crypto.h"
+#include "isodep.h"
+
+/* PICCDataTag: UID mirroring, SDMReadCtr mirroring, 7 byte UID */
+#define PICC_DATA_TAG             0xC7
+
+#define SW_OK_1                   0x90
+#define SW_OK_2                   0x00
+
+/* Read counters per UID; cached copy of the SUN_COUNTERS token */
+static tokTypeSunCounter sunCounters[SUN_COUNTERS_ELEMENTS];
+static uint32_t persisted[SUN_COUNTERS_ELEMENTS];   /**< Counter last written to NVM3 */
+static uint32_t lastSeen = 0;                 /**< Highest tap sequence number in sunCounters */
+
+/** @brief Load read counters from NVM3
+ *  @note The tap sequence continues from the highest one stored, so the
+ *        eviction order survives a reboot (as of the last write per tag).
+ *        Reads not yet written may have been accepted before the reboot,
+ *        so counters up to RFID_SUN_PERSIST_STEP - 1 past the stored one
+ *        are treated as seen.
+ */
+void sunInit(void)
+{
+  lastSeen = 0;
+
+  for (uint8_t i = 0; i < SUN_COUNTERS_ELEMENTS; i++) {
+    halCommonGetIndexedToken(&sunCounters[i], TOKEN_SUN_COUNTERS, i);
+    persisted[i] = sunCounters[i].counter;
+    if (sunCounters[i].seen != 0)
+      sunCounters[i].counter += RFID_SUN_PERSIST_STEP - 1;
+    if (sunCounters[i].seen > lastSeen)
+      lastSeen = sunCounters[i].seen;
+  }
+}
+
+/** @brief Entry to reuse for an unknown UID: a free one, else the least recently seen
+ */
+static uint8_t evictCounter(void)
+{
+  uint8_t oldest = 0;
+
+  for (uint8_t i = 1; i < SUN_COUNTERS_ELEMENTS; i++) {
+    if (sunCounters[i].seen < sunCounters[oldest].seen)
+      oldest = i;
+  }
+
+  if (sunCounters[oldest].seen != 0)
+    emberAfCorePrintln("SUN: read counter %d evicted, no replay check for its UID any more", oldest);
+
+  return oldest;
+}
+
+/** @brief Check a read counter against the last one seen for the UID
+ *  @param uid 7 byte UID
+ *  @param counter SDMReadCtr
+ *  @return true if the counter is new; it is then stored
+ *  @note Written to NVM3 for a new UID and then every RFID_SUN_PERSIST_STEP;
+ *        counter and tap sequence number are in the same object
+ */
+static bool checkCounter(const uint8_t *uid, const uint32_t counter)
+{
+  bool stored = true;
+  uint8_t i;
+
+  for (i = 0; i < SUN_COUNTERS_ELEMENTS; i++) {
+    if ((sunCounters[i].seen != 0) && (memcmp(sunCounters[i].uid, uid, SUN_UID_SIZE) == 0))
+      break;
+  }
+
+  if (i < SUN_COUNTERS_ELEMENTS) {
+    if (counter <= sunCounters[i].counter) {
+      emberAfCorePrintln("ERROR: SUN replay (counter %d, last %d)", counter, sunCounters[i].counter);
+      return false;
+    }
+  }
+  else {
+    i = evictCounter();
+    memcpy(sunCounters[i].uid, uid, SUN_UID_SIZE);
+    stored = false;
+  }
+
+  sunCounters[i].counter = counter;
+  sunCounters[i].seen = ++lastSeen;
+
+  if (!stored || (counter - persisted[i] >= RFID_SUN_PERSIST_STEP)) {
+    halCommonSetIndexedToken(TOKEN_SUN_COUNTERS, i, &sunCounters[i]);
+    persisted[i] = counter;
+  }
+  return true;
+
+}
+
+/** @brief Decode hex string
+ *  @return true if all characters were hex digits
+ */
+static bool hexDecode(const uint8_t *hex, const uint8_t len, uint8_t *out)
+{
+  for (uint8_t i = 0; i < 2 * len; i++) {
+    uint8_t c = hex[i], v;
+
+    if (c >= '0' && c <= '9')
+      v = c - '0';
+    else if (c >= 'A' && c <= 'F')
+      v = c - 'A' + 10;
+    else if (c >= 'a' && c <= 'f')
+      v = c - 'a' + 10;
+    else
+      return false;
+
+    if (i & 1)
+      out[i / 2] |= v;
+    else
+      out[i / 2] = v << 4;
+  }
+
+  return true;
+}
+
+/** @brief Find the hex value of a URL parameter
+ *  @param buf NDEF file data
+ *  @param len Length of data
+ *  @param param Parameter name incl. '='
+ *  @param out Buffer for the decoded value
+ *  @param outLen Number of bytes to decode
+ *  @return true if found and decoded
+ */
+static bool findParam(const uint8_t *buf, const uint16_t len, const char *param, uint8_t *out, const uint8_t outLen)
+{
+  uint16_t plen = strlen(param);
+
+  for (uint16_t i = 0; i + plen + 2 * outLen <= len; i++) {
+    if (memcmp(&buf[i], param, plen) == 0)
+      return hexDecode(&buf[i + plen], outLen, out);
+  }
+
+  return false;
+}
+
+/** @brief Verify a SUN message (encrypted PICC data and SDM MAC)
+ *  @param ndef NDEF file data
+ *  @param len Length of data
+ *  @param rfid_tag Selected tag; the mirrored UID must match
+ *  @return true if the MAC is valid and the read counter is new
+ *  @note Assumes SDMMACInputOffset == SDMMACOffset (MAC over no file data),
+ *        which is the usual setup for URL based SUN messages
+ */
+bool sunVerify(const uint8_t *ndef, const uint16_t len, const rfid_tag_t *rfid_tag)
+{
+  uint8_t picc[SUN_PICC_DATA_SIZE];
+  uint8_t macT[SUN_MAC_SIZE];
+  uint8_t mac[RFID_AES_BLOCK_SIZE];
+  uint8_t sv2[RFID_AES_BLOCK_SIZE] = { 0x3C, 0xC3, 0x00, 0x01, 0x00, 0x80 };
+  bool ok = false;
+
+  if (!findParam(ndef, len, RFID_SUN_PICC_PARAM, picc, sizeof(picc))
+      || !findParam(ndef, len, RFID_SUN_CMAC_PARAM, macT, sizeof(macT))) {
+    emberAfCorePrintln("ERROR: no SUN message");
+    return false;
+  }
+
+  // PICCData = PICCDataTag || UID || SDMReadCtr || random
+  if (!rfidCryptoAesCbc(RFID_KEY_ID(RFID_SUN_META_KEY), false, NULL, picc, sizeof(picc), picc))
+    return false;
+
+  if ((picc[0] != PICC_DATA_TAG)
+      || (rfid_tag->size != SUN_UID_SIZE)
+      || (memcmp(&picc[1], rfid_tag->rfid, SUN_UID_SIZE) != 0)) {
+    emberAfCorePrintln("ERROR: SUN PICC data mismatch");
+    goto exit;
+  }
+
+  uint32_t counter = picc[8] | (picc[9] << 8) | ((uint32_t)picc[10] << 16);
+
+  // KSesSDMFileReadMAC = CMAC(SDMFileReadKey, SV2)
+  memcpy(&sv2[6], &picc[1], SUN_UID_SIZE + 3);
+  psa_key_id_t sesKey = rfidCryptoDeriveKey(RFID_KEY_ID(RFID_SUN_FILE_KEY), sv2, sizeof(sv2));
+
+  if (sesKey == 0)
+    goto exit;
+
+  ok = rfidCryptoCmac(sesKey, NULL, 0, mac);
+  rfidCryptoDestroyKey(&sesKey);
+
+  // Truncated MAC is every odd byte of the CMAC
+  for (uint8_t i = 0; ok && i < SUN_MAC_SIZE; i++) {
+    if (mac[2 * i + 1] != macT[i])
+      ok = false;
+  }
+
+  if (!ok) {
+    emberAfCorePrintln("ERROR: SUN MAC mismatch");
+    goto exit;
+  }
+
+  ok = checkCounter(rfid_tag->rfid, counter);
+
+exit:
+  mbedtls_platform_zeroize(picc, sizeof(picc));
+  mbedtls_platform_zeroize(sv2, sizeof(sv2));
+  return ok;
+
+}
+
+/** @brief Send an ISO7816 APDU and check the status word
+ *  @return Length of response data (without status word), or -1 on error
+ */
+static int16_t apdu(uint8_t *cmd, const uint8_t len, uint8_t *resp, const uint16_t rlen)
+{
+  int16_t res = isodepTransceive(cmd, len, resp, rlen);
+
+  if ((res < 2) || (resp[res - 2] != SW_OK_1) || (resp[res - 1] != SW_OK_2))
+    return -1;
+
+  return res - 2;
+}
+
+/** @brief Read the NDEF file of a selected NTAG 424 DNA and verify its SUN message
+ *  @param rfid_tag Selected tag
+ *  @return true if verified
+ *  @note ISO-DEP must be active (isodepActivate)
+ */
+bool sunCheckTag(const rfid_tag_t *rfid_tag)
+{
+  uint8_t selectApp[] = { 0x00, 0xA4, 0x04, 0x0C, 0x07, 0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01, 0x00 };
+  uint8_t selectFile[] = { 0x00, 0xA4, 0x00, 0x0C, 0x02, 0xE1, 0x04 };
+  uint8_t readBinary[] = { 0x00, 0xB0, 0x00, 0x00, SUN_NDEF_MAX };
+  uint8_t resp[SUN_NDEF_MAX + 2];
+  int16_t len;
+
+  if ((apdu(selectApp, sizeof(selectApp), resp, sizeof(resp)) < 0)
+      || (apdu(selectFile, sizeof(selectFile), resp, sizeof(resp)) < 0)
+      || ((len = apdu(readBinary, sizeof(readBinary), resp, sizeof(resp))) < 0)) {
+    emberAfCorePrintln("ERROR: failed to read NDEF file");
+    return false;
+  }
+
+  return sunVerify(resp, len, rfid_tag);
+
+}
@@ -0,0 +1,24 @@
+/*
+ * sun.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef SUN_H_
+#define SUN_H_
+
+#include "app/framework/include/af.h"
+
+#include "rfid.h"
+
+#define SUN_UID_SIZE              7
+#define SUN_PICC_DATA_SIZE        16
+#define SUN_MAC_SIZE              8
+#define SUN_NDEF_MAX              128         /**< Max. bytes read from the NDEF file */
+
+void sunInit(void);
+bool sunVerify(const uint8_t *ndef, uint16_t len, const rfid_tag_t *rfid_tag);
+bool sunCheckTag(const rfid_tag_t *rfid_tag);
+
+#endif /* SUN_H_ */
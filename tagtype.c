@@ -0,0 +1,313 @@
+/*
+ * tagtype.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "tagtype.h"
+
+#include "rfid_config.h"
+#include "isodep.h"
+#include "cache.h"
+#include "desfire.h"
+#include "mifare.h"
+#include "ndef.h"
+#include "ntag.h"
+#include "originality.h"
+#include "sun.h"
+
+/* ATQA bits 7..6 only give the UID size; ignore them when matching */
+#define ATQA_TYPE_MASK            0xFF3F
+
+/* GET_VERSION product type */
+#define NTAG_PRODUCT_NTAG         0x04
+
+/*! ATQA/SAK match; the first matching entry wins (NXP AN10833) */
+typedef struct {
+  uint16_t atqaMask;
+  uint16_t atqa;
+  uint8_t sakMask;
+  uint8_t sak;
+  tag_family_t family;
+} tag_match_t;
+
+static const tag_match_t tagMatch[] = {
+  { 0x0000, 0x0000, 0xFF, 0x09, TAG_FAMILY_CLASSIC_MINI },
+  { 0x0000, 0x0000, 0xFF, 0x08, TAG_FAMILY_CLASSIC_1K },
+  { 0x0000, 0x0000, 0xFF, 0x18, TAG_FAMILY_CLASSIC_4K },
+  { 0x0000, 0x0000, 0xFF, 0x00, TAG_FAMILY_ULTRALIGHT },
+  { 0x0000, 0x0000, 0xFF, 0x10, TAG_FAMILY_PLUS },                 // SL2 2K
+  { 0x0000, 0x0000, 0xFF, 0x11, TAG_FAMILY_PLUS },                 // SL2 4K
+  { ATQA_TYPE_MASK, 0x0304, 0xFF, 0x20, TAG_FAMILY_DESFIRE },
+  { ATQA_TYPE_MASK, 0x0004, 0xFF, 0x20, TAG_FAMILY_PLUS },         // SL3
+  { ATQA_TYPE_MASK, 0x0002, 0xFF, 0x20, TAG_FAMILY_PLUS },         // SL3
+  { 0x0000, 0x0000, ISODEP_SAK_COMPLIANT, ISODEP_SAK_COMPLIANT, TAG_FAMILY_ISODEP }
+};
+
+#define TAG_MATCHES               (sizeof(tagMatch) / sizeof(tagMatch[0]))
+
+static bool uidPipeline(const rfid_tag_t *rfid_tag);
+static bool classicPipeline(const rfid_tag_t *rfid_tag);
+static bool ultralightPipeline(const rfid_tag_t *rfid_tag);
+static bool isodepPipeline(const rfid_tag_t *rfid_tag);
+static bool desfirePipeline(const rfid_tag_t *rfid_tag);
+
+/*! Name and read pipeline per family, indexed by tag_family_t */
+static const struct {
+  const char *name;
+  bool (*pipeline)(const rfid_tag_t *rfid_tag);
+} tagFamily[TAG_FAMILIES] = {
+  [TAG_FAMILY_UNKNOWN] = { "unknown", uidPipeline },
+  [TAG_FAMILY_CLASSIC_MINI] = { "MIFARE Classic Mini", classicPipeline },
+  [TAG_FAMILY_CLASSIC_1K] = { "MIFARE Classic 1K", classicPipeline },
+  [TAG_FAMILY_CLASSIC_4K] = { "MIFARE Classic 4K", classicPipeline },
+  [TAG_FAMILY_ULTRALIGHT] = { "Ultralight/NTAG", ultralightPipeline },
+  [TAG_FAMILY_PLUS] = { "MIFARE Plus", uidPipeline },
+  [TAG_FAMILY_DESFIRE] = { "DESFire", desfirePipeline },
+  [TAG_FAMILY_ISODEP] = { "ISO-DEP", isodepPipeline }
+};
+
+/** @brief Classify a tag from ATQA and SAK
+ *  @param rfid_tag Selected tag
+ *  @return Tag family; TAG_FAMILY_UNKNOWN for tags that are not ISO14443A
+ */
+tag_family_t tagTypeClassify(const rfid_tag_t *rfid_tag)
+{
+  if (rfid_tag->protocol != MFRC630_PROTO_ISO14443A_106)
+    return TAG_FAMILY_UNKNOWN;
+
+  for (uint8_t i = 0; i < TAG_MATCHES; i++) {
+    if (((rfid_tag->atqa & tagMatch[i].atqaMask) == tagMatch[i].atqa)
+        && ((rfid_tag->sak & tagMatch[i].sakMask) == tagMatch[i].sak))
+      return tagMatch[i].family;
+  }
+
+  return TAG_FAMILY_UNKNOWN;
+
+}
+
+/** @brief Get family name
+ */
+const char *tagTypeName(const tag_family_t family)
+{
+  return (family < TAG_FAMILIES) ? tagFamily[family].name : "invalid";
+}
+
+#if RFID_CLASSIC_READ || RFID_NDEF_READ || RFID_DESFIRE_READ
+/** @brief Print a payload read from a tag (or the cache)
+ */
+static void printPayload(const char *name, const uint8_t *payload, const int16_t len)
+{
+  emberAfCorePrint("%s:", name);
+  for (int16_t i = 0; i < len; i++)
+    emberAfCorePrint(" %x", payload[i]);
+  emberAfCorePrintln("");
+}
+#endif
+
+#if RFID_NDEF_READ
+/** @brief Read the payload of the first NDEF record, or get it from the cache
+ */
+static void ndefPipeline(const rfid_tag_t *rfid_tag, const ntag_info_t *info)
+{
+  uint8_t payload[CACHE_PAYLOAD_MAX];
+  uint16_t source = CACHE_SOURCE(tagTypeClassify(rfid_tag), 0);
+  ndef_reader_t reader;
+  ndef_record_t record;
+  int16_t len;
+
+  len = cacheLookup(rfid_tag, source, payload, sizeof(payload));
+  if (len < 0) {
+    ndefReaderInit(&reader, info);
+    if (!ndefFindRecord(&reader, NULL, 0, NULL, 0, &record)) {
+      emberAfCorePrintln("no NDEF record");
+      return;
+    }
+
+    cacheStore(rfid_tag, source, record.payload, record.payloadLength);
+    printPayload("ndef", record.payload, record.payloadLength);
+    return;
+  }
+
+  printPayload("ndef", payload, len);
+}
+#endif
+
+/** @brief Tags with nothing to read beyond the UID
+ */
+static bool uidPipeline(const rfid_tag_t *rfid_tag)
+{
+  (void)rfid_tag;
+  return true;
+}
+
+/** @brief Update the value block and read the configured sector with the key in the reader EEPROM
+ *  @return true if both are disabled, or they succeeded
+ *  @note Each step authenticates on its own; the card is re-selected in
+ *        between. The sector holding the value block is never cached.
+ */
+static bool classicPipeline(const rfid_tag_t *rfid_tag)
+{
+#if RFID_CLASSIC_VALUE_OP
+  mifare_value_timing_t timing;
+  int32_t value;
+
+  if (!mifareValueOperation(RFID_CLASSIC_VALUE_BLOCK, RFID_CLASSIC_VALUE_OP, RFID_CLASSIC_VALUE_AMOUNT,
+                            RFID_CLASSIC_KEY_TYPE, RFID_CLASSIC_KEY,
+                            rfid_tag->rfid, rfid_tag->size, &value, &timing))
+    return false;
+
+  emberAfCorePrintln("value %d (auth %d ms, read %d ms, op %d ms, verify %d ms)",
+                     value, timing.auth, timing.read, timing.operation, timing.verify);
+#endif
+#if RFID_CLASSIC_READ
+  static const uint8_t sectors[] = {
+    [TAG_FAMILY_CLASSIC_MINI] = 5,
+    [TAG_FAMILY_CLASSIC_1K] = 16,
+    [TAG_FAMILY_CLASSIC_4K] = 40
+  };
+  uint8_t buffer[16 * MIFARE_BLOCK_SIZE];
+  uint8_t first = mifareSectorFirstBlock(RFID_CLASSIC_SECTOR);
+  bool cacheable = !RFID_CLASSIC_VALUE_OP
+                   || (RFID_CLASSIC_VALUE_BLOCK < first)
+                   || (RFID_CLASSIC_VALUE_BLOCK >= first + mifareSectorBlocks(RFID_CLASSIC_SECTOR));
+  uint16_t source = CACHE_SOURCE(tagTypeClassify(rfid_tag), RFID_CLASSIC_SECTOR);
+  int16_t len = -1;
+
+  if (RFID_CLASSIC_SECTOR >= sectors[tagTypeClassify(rfid_tag)]) {
+    emberAfCorePrintln("ERROR: no sector %d on this card", RFID_CLASSIC_SECTOR);
+    return false;
+  }
+
+  // A cached sector is trusted without authenticating again
+  if (cacheable)
+    len = cacheLookup(rfid_tag, source, buffer, sizeof(buffer));
+
+  if (len < 0) {
+    if (RFID_CLASSIC_VALUE_OP && !mifareReselect(rfid_tag->rfid, rfid_tag->size)) {
+      emberAfCorePrintln("ERROR: card not re-selected");
+      return false;
+    }
+
+    len = mifareReadSector(RFID_CLASSIC_SECTOR, RFID_CLASSIC_KEY_TYPE, RFID_CLASSIC_KEY,
+                           rfid_tag->rfid, rfid_tag->size, buffer, sizeof(buffer));
+    if (len < 0)
+      return false;
+    if (cacheable)
+      cacheStore(rfid_tag, source, buffer, len);
+  }
+
+  printPayload("sector", buffer, len);
+#endif
+#if !RFID_CLASSIC_READ && !RFID_CLASSIC_VALUE_OP
+  (void)rfid_tag;
+#endif
+  return true;
+}
+
+/** @brief Tell NTAG and Ultralight variants apart with GET_VERSION, then
+ *         check originality and read the NDEF record
+ *  @return true if originality checking is disabled, or the tag passed it
+ *  @note Tags without GET_VERSION (Ultralight, Ultralight C) have no
+ *        originality signature either, so READ_SIG is not tried on them.
+ */
+static bool ultralightPipeline(const rfid_tag_t *rfid_tag)
+{
+  ntag_info_t info;
+
+  if (!ntagGetVersion(&info)) {
+    emberAfCorePrintln("Ultralight (no GET_VERSION)");
+#if RFID_ORIGINALITY_CHECK
+    return false;
+#else
+    return true;
+#endif
+  }
+
+  emberAfCorePrintln("%s, %d pages", info.version[2] == NTAG_PRODUCT_NTAG ? "NTAG" : "Ultralight EV1", info.pages);
+
+#if RFID_ORIGINALITY_CHECK
+  originality_result_t result = originalityCheck(rfid_tag);
+
+  if (result == ORIGINALITY_FAILED)
+    return false;
+#endif
+#if RFID_NDEF_READ
+  ndefPipeline(rfid_tag, &info);
+#endif
+#if !RFID_ORIGINALITY_CHECK && !RFID_NDEF_READ
+  (void)rfid_tag;
+#endif
+  return true;
+}
+
+/** @brief Verify the SUN message of an activated ISO-DEP tag
+ *  @return true if SUN verification is disabled, or the tag passed it
+ */
+static bool sunPipeline(const rfid_tag_t *rfid_tag)
+{
+#if RFID_SUN_VERIFY
+  return sunCheckTag(rfid_tag);
+#else
+  (void)rfid_tag;
+  return true;
+#endif
+}
+
+/** @brief Verify the SUN message of ISO-DEP tags (NTAG 424 DNA)
+ *  @return true if SUN verification is disabled, or the tag passed it
+ */
+static bool isodepPipeline(const rfid_tag_t *rfid_tag)
+{
+#if RFID_SUN_VERIFY
+  if (!isodepActivate())
+    return false;
+#endif
+  return sunPipeline(rfid_tag);
+}
+
+/** @brief Authenticate and read the configured data file of DESFire cards
+ *  @return true if the file was read; without RFID_DESFIRE_READ, for
+ *          NTAG 424 DNA (same ATQA/SAK) and for cards without
+ *          RFID_DESFIRE_AID the ISO-DEP pipeline decides
+ */
+static bool desfirePipeline(const rfid_tag_t *rfid_tag)
+{
+#if RFID_DESFIRE_READ
+  uint8_t buffer[RFID_DESFIRE_LENGTH];
+  uint8_t hwType = 0;
+  int16_t len;
+
+  if (!isodepActivate())
+    return false;
+
+  if (!desfireGetHwType(&hwType) || (hwType != DESFIRE_HW_TYPE_DESFIRE)) {
+    emberAfCorePrintln("not a DESFire (hw type 0x%x)", hwType);
+    return sunPipeline(rfid_tag);
+  }
+
+  len = desfireReadTag(rfid_tag, buffer, sizeof(buffer));
+  if (len == DESFIRE_NO_APPLICATION)
+    return sunPipeline(rfid_tag);
+  if (len < 0)
+    return false;
+
+  printPayload("file", buffer, len);
+  return true;
+#else
+  return isodepPipeline(rfid_tag);
+#endif
+}
+
+/** @brief Classify a tag and run the read pipeline of its family
+ *  @param rfid_tag Selected tag
+ *  @return true if the tag may be reported
+ */
+bool tagTypeProcess(const rfid_tag_t *rfid_tag)
+{
+  tag_family_t family = tagTypeClassify(rfid_tag);
+
+  emberAfCorePrintln("tag type: %s (atqa 0x%2x, sak 0x%x)", tagFamily[family].name, rfid_tag->atqa, rfid_tag->sak);
+  return tagFamily[family].pipeline(rfid_tag);
+}
@@ -0,0 +1,32 @@
+/*
+ * tagtype.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef TAGTYPE_H_
+#define TAGTYPE_H_
+
+#include "app/framework/include/af.h"
+
+#include "rfid.h"
+
+/*! Tag families with their own read pipeline */
+typedef enum {
+  TAG_FAMILY_UNKNOWN = 0,                     /**< UID only (also non-ISO14443A tags) */
+  TAG_FAMILY_CLASSIC_MINI,
+  TAG_FAMILY_CLASSIC_1K,
+  TAG_FAMILY_CLASSIC_4K,
+  TAG_FAMILY_ULTRALIGHT,                      /**< Ultralight, Ultralight EV1/C, NTAG21x */
+  TAG_FAMILY_PLUS,                            /**< MIFARE Plus in SL2 or SL3 */
+  TAG_FAMILY_DESFIRE,                         /**< DESFire EV1/EV2/EV3, NTAG 424 DNA */
+  TAG_FAMILY_ISODEP,                          /**< Other ISO14443-4 cards */
+  TAG_FAMILIES
+} tag_family_t;
+
+tag_family_t tagTypeClassify(const rfid_tag_t *rfid_tag);
+const char *tagTypeName(tag_family_t family);
+bool tagTypeProcess(const rfid_tag_t *rfid_tag);
+
+#endif /* TAGTYPE_H_ */
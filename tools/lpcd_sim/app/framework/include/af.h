@@ -0,0 +1,34 @@
+/*
+ * af.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ *
+ * Host stand-in for the Zigbee application framework header, with just
+ * what lpcd.c and duty.c use. Time and tokens come from lpcd_sim.c.
+ */
+
+#ifndef LPCD_SIM_AF_H_
+#define LPCD_SIM_AF_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DEFINETYPES
+#include "sl_custom_token_header.h"
+#undef DEFINETYPES
+
+#define TOKEN_LPCD_CALIBRATION    0
+
+void simLog(const char *format, ...);
+uint32_t halCommonGetInt32uMillisecondTick(void);
+void simGetToken(void *data, int token);
+void simSetToken(int token, const void *data);
+
+#define emberAfCorePrintln(...)             simLog(__VA_ARGS__)
+#define halCommonGetToken(data, token)      simGetToken((data), (token))
+#define halCommonSetToken(token, data)      simSetToken((token), (data))
+
+#endif /* LPCD_SIM_AF_H_ */
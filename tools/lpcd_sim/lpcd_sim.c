@@ -0,0 +1,625 @@
+/*
+ * lpcd_sim.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ *
+ * Host simulator for low power card detection. The real lpcd.c and duty.c
+ * run against a model of the CLRC663 LPCD registers, fed by synthetic
+ * scenarios (noise, temperature drift, metal nearby, card traffic) or by a
+ * recorded trace. Detection latency, miss rate, false wake rate and the
+ * time spent on reader access and probes (awake/h, s per hour) are
+ * reported per scenario. No reader or Zigbee stack is needed.
+ *
+ * Build and run all algorithm variants from the repository root:
+ *
+ *   for v in 0 1 2 3; do
+ *     gcc -std=c99 -O2 -DSIM_VARIANT=$v -Itools/lpcd_sim -Iconfig -I. \
+ *         tools/lpcd_sim/lpcd_sim.c lpcd.c duty.c -lm -o /tmp/lpcd_sim$v && /tmp/lpcd_sim$v
+ *   done
+ *
+ * Variants (tools/lpcd_sim/rfid_config.h): 0 fixed window, 1 EWMA baseline,
+ * 2 EWMA baseline + threshold tuning, 3 as configured (+ adaptive period).
+ *
+ * Usage: lpcd_sim [-v] [-s seed] [trace.csv]
+ *   -v         print the firmware log
+ *   -s seed    seed for the synthetic scenarios (default 1)
+ *   trace.csv  recorded trace instead of the synthetic scenarios; one
+ *              "ms,i,q,card" line per I/Q sample, card = 1 while a card
+ *              that can be read is in the field
+ */
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+
+#include "lpcd.h"
+#include "duty.h"
+#include "energy.h"
+#include "report.h"
+#include "rfid_config.h"
+
+#define SIM_HOURS                 24
+#define SIM_MS_PER_HOUR           3600000UL
+#define SIM_CARDS_MAX             4096
+#define SIM_TRACE_MAX             500000
+#define SIM_TIMER_HZ              32768
+
+/* Cost of reader access with the polled transfers in i2c.c at 200 kHz, as
+ * timed on the host I2C harness: a write8 is 3 bytes, a read8 is 2 + 2 bytes
+ * with a repeated start. Soft reset is the 50 ms delay in rfidSoftReset. */
+#define I2C_WRITE_US              140
+#define I2C_READ_US               190
+#define SOFT_RESET_US             50000
+
+/* Awake time of a wake without a card, see handleTag: 5V rail settle, then
+ * pollProbe (LOADPROTOCOL, antenna registers incl. an 18 byte burst, WUPA
+ * setup, IRQ polling through the RFID_POLL_PROBE_TIMEOUT frame wait) and
+ * fieldEnd; 32 writes, 12 reads and about 1250 us of FIFO/burst writes.
+ * lpcdCapture and the re-arm are counted by read8/write8. */
+#define PROBE_RAIL_US             (RFID_RAIL_LPCD ? 0 : RFID_RAIL_SETTLE_MS * 1000)
+#define PROBE_US                  (PROBE_RAIL_US + 32 * I2C_WRITE_US + 12 * I2C_READ_US + 1250)
+
+/* Undisturbed I/Q results */
+#define BASE_I                    32
+#define BASE_Q                    30
+
+/* A card ramps in and out over this time and can be read from this fraction of its effect */
+#define APPROACH_MS               300
+#define READABLE_PERCENT          60
+
+typedef struct {
+  uint32_t arrive;                            /**< ms from scenario start */
+  uint32_t leave;
+  int8_t di;                                  /**< I/Q shift with the card fully in the field */
+  int8_t dq;
+  bool detected;
+} sim_card_t;
+
+typedef struct {
+  const char *name;
+  uint8_t noise;                              /**< Noise sigma (1/10 counts) */
+  uint8_t drift;                              /**< Peak temperature drift (counts) over a day */
+  uint8_t cardsPerHour;
+  int8_t metalI;                              /**< Baseline shift between 06:00 and 18:00 */
+  int8_t metalQ;
+} sim_scenario_t;
+
+typedef struct {
+  uint32_t ms;
+  uint8_t i;
+  uint8_t q;
+  bool card;
+} sim_sample_t;
+
+static const sim_scenario_t scenarios[] = {
+  { "quiet", 5, 1, 2, 0, 0 },
+  { "busy", 5, 1, 60, 0, 0 },
+  { "drift", 5, 6, 6, 0, 0 },
+  { "noisy", 15, 1, 6, 0, 0 },
+  { "metal", 5, 1, 6, 5, -4 },
+};
+
+/* Simulated time and reader model */
+static uint64_t simUs = 0;
+static uint64_t scenarioStartUs = 0;
+static uint8_t regs[256];
+static uint8_t resultI = 0;
+static uint8_t resultQ = 0;
+static bool armed = false;
+static tokTypeLpcdCalibration token;
+static bool verbose = false;
+static uint32_t seed = 1;
+
+/* Input */
+static const sim_scenario_t *scenario = NULL;
+static sim_card_t cards[SIM_CARDS_MAX];
+static uint16_t cardCount = 0;
+static uint16_t currentCard = 0;
+static sim_sample_t *trace = NULL;
+static uint32_t traceCount = 0;
+static uint32_t traceIndex = 0;
+
+/* Results */
+static uint32_t latencies[SIM_CARDS_MAX];
+static uint16_t detected = 0;
+static uint32_t wakes = 0;
+static uint64_t awakeUs = 0;                  /**< Reader access and probes; card reads not counted */
+static uint32_t falseWakes = 0;
+static uint32_t earlyWakes = 0;
+static uint32_t thresholdReports = 0;
+static uint64_t periodSum = 0;
+static uint32_t periodCount = 0;
+
+/*---------------------------------------------------------------------------
+ * Firmware environment
+ *-------------------------------------------------------------------------*/
+
+void simLog(const char *format, ...)
+{
+  if (!verbose)
+    return;
+
+  va_list args;
+  va_start(args, format);
+  printf("[%8lu ms] ", (unsigned long)(simUs / 1000));
+  vprintf(format, args);
+  printf("\n");
+  va_end(args);
+}
+
+uint32_t halCommonGetInt32uMillisecondTick(void)
+{
+  return (uint32_t)(simUs / 1000);
+}
+
+uint32_t sl_sleeptimer_get_tick_count(void)
+{
+  return (uint32_t)((simUs * SIM_TIMER_HZ) / 1000000);
+}
+
+uint32_t sl_sleeptimer_get_timer_frequency(void)
+{
+  return SIM_TIMER_HZ;
+}
+
+void simGetToken(void *data, int tokenId)
+{
+  (void)tokenId;
+  memcpy(data, &token, sizeof(token));
+}
+
+void simSetToken(int tokenId, const void *data)
+{
+  (void)tokenId;
+  memcpy(&token, data, sizeof(token));
+}
+
+bool reportLpcdThreshold(uint8_t threshold, uint32_t count)
+{
+  (void)threshold;
+  (void)count;
+  thresholdReports++;
+  return true;
+}
+
+void energyPhaseBegin(energy_phase_t phase)
+{
+  (void)phase;
+}
+
+void energyPhaseEnd(energy_phase_t phase)
+{
+  (void)phase;
+}
+
+void energyLpcdArmed(uint16_t periodMs)
+{
+  (void)periodMs;
+}
+
+/*---------------------------------------------------------------------------
+ * Input: synthetic scenario or recorded trace
+ *-------------------------------------------------------------------------*/
+
+static uint32_t randomNext(void)
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+/** @brief Uniform in [0, 1)
+ */
+static double randomUniform(void)
+{
+  return (randomNext() >> 8) / 16777216.0;
+}
+
+/** @brief Approximately normal, mean 0 and sigma 1 (Irwin-Hall)
+ */
+static double randomNormal(void)
+{
+  double sum = 0;
+
+  for (uint8_t n = 0; n < 12; n++)
+    sum += randomUniform();
+
+  return sum - 6;
+}
+
+/** @brief Place cards with exponential gaps; one card in the field at a time
+ */
+static void generateCards(const uint32_t durationMs)
+{
+  uint32_t t = 0;
+
+  cardCount = 0;
+  if (scenario->cardsPerHour == 0)
+    return;
+
+  while (cardCount < SIM_CARDS_MAX) {
+    double gap = -((double)SIM_MS_PER_HOUR / scenario->cardsPerHour) * log(1 - randomUniform());
+    t += 1000 + (uint32_t)gap;
+    if (t >= durationMs)
+      break;
+
+    sim_card_t *card = &cards[cardCount++];
+    card->arrive = t;
+    card->leave = t + 2 * APPROACH_MS + 1000 + randomNext() % 3000;
+    card->di = -(int8_t)(6 + randomNext() % 9);
+    card->dq = (int8_t)(4 + randomNext() % 7);
+    card->detected = false;
+    t = card->leave;
+  }
+}
+
+/** @brief Card in the field at t, NULL if none
+ */
+static sim_card_t *cardAt(const uint32_t t)
+{
+  while ((currentCard < cardCount) && (cards[currentCard].leave <= t))
+    currentCard++;
+
+  if ((currentCard < cardCount) && (cards[currentCard].arrive <= t))
+    return &cards[currentCard];
+
+  return NULL;
+}
+
+/** @brief Share of the card's I/Q shift at t (percent)
+ */
+static uint32_t cardPercent(const sim_card_t *card, const uint32_t t)
+{
+  uint32_t in = t - card->arrive;
+  uint32_t out = card->leave - t;
+  uint32_t edge = (in < out) ? in : out;
+
+  return (edge >= APPROACH_MS) ? 100 : edge * 100 / APPROACH_MS;
+}
+
+static uint8_t clampResult(const double value)
+{
+  if (value < 0)
+    return 0;
+  if (value > LPCD_RESULT_MAX)
+    return LPCD_RESULT_MAX;
+  return (uint8_t)(value + 0.5);
+}
+
+/** @brief Triangle wave over a day, -1..1
+ */
+static double dayWave(const uint32_t t)
+{
+  double phase = (double)(t % (SIM_HOURS * SIM_MS_PER_HOUR)) / (SIM_HOURS * SIM_MS_PER_HOUR);
+
+  return (phase < 0.5) ? 4 * phase - 1 : 3 - 4 * phase;
+}
+
+/** @brief I/Q result and card readability at t
+ *  @return true if a card that can be read is in the field
+ */
+static bool sampleAt(const uint32_t t, uint8_t *i, uint8_t *q)
+{
+  if (trace != NULL) {
+    while ((traceIndex + 1 < traceCount) && (trace[traceIndex + 1].ms <= t))
+      traceIndex++;
+    *i = trace[traceIndex].i & LPCD_RESULT_MASK;
+    *q = trace[traceIndex].q & LPCD_RESULT_MASK;
+    return trace[traceIndex].card;
+  }
+
+  double vi = BASE_I + scenario->drift * dayWave(t) + randomNormal() * scenario->noise / 10;
+  double vq = BASE_Q - scenario->drift * dayWave(t) / 2 + randomNormal() * scenario->noise / 10;
+  uint32_t hour = (t / SIM_MS_PER_HOUR) % 24;
+
+  if ((hour >= 6) && (hour < 18)) {
+    vi += scenario->metalI;
+    vq += scenario->metalQ;
+  }
+
+  sim_card_t *card = cardAt(t);
+  uint32_t percent = (card != NULL) ? cardPercent(card, t) : 0;
+  if (card != NULL) {
+    vi += card->di * percent / 100.0;
+    vq += card->dq * percent / 100.0;
+  }
+
+  *i = clampResult(vi);
+  *q = clampResult(vq);
+  return percent >= READABLE_PERCENT;
+}
+
+/** @brief Read a "ms,i,q,card" trace; cards are the runs of card = 1
+ */
+static bool loadTrace(const char *path)
+{
+  FILE *file = fopen(path, "r");
+  char line[128];
+
+  if (file == NULL)
+    return false;
+
+  trace = calloc(SIM_TRACE_MAX, sizeof(sim_sample_t));
+  cardCount = 0;
+
+  while ((traceCount < SIM_TRACE_MAX) && (fgets(line, sizeof(line), file) != NULL)) {
+    unsigned ms, i, q, card;
+    if (sscanf(line, "%u,%u,%u,%u", &ms, &i, &q, &card) != 4)
+      continue;
+
+    sim_sample_t *sample = &trace[traceCount++];
+    sample->ms = ms;
+    sample->i = (uint8_t)i;
+    sample->q = (uint8_t)q;
+    sample->card = (card != 0);
+
+    bool inCard = (cardCount > 0) && (cards[cardCount - 1].leave == 0);
+    if (sample->card && !inCard && (cardCount < SIM_CARDS_MAX)) {
+      memset(&cards[cardCount], 0, sizeof(sim_card_t));
+      cards[cardCount++].arrive = ms;
+    }
+    else if (!sample->card && inCard)
+      cards[cardCount - 1].leave = ms;
+  }
+
+  fclose(file);
+
+  if ((cardCount > 0) && (cards[cardCount - 1].leave == 0))
+    cards[cardCount - 1].leave = trace[traceCount - 1].ms;
+
+  return traceCount > 0;
+}
+
+/*---------------------------------------------------------------------------
+ * CLRC663 model
+ *-------------------------------------------------------------------------*/
+
+static uint32_t scenarioMs(void)
+{
+  return (uint32_t)((simUs - scenarioStartUs) / 1000);
+}
+
+static void measure(void)
+{
+  sampleAt(scenarioMs(), &resultI, &resultQ);
+}
+
+static void command(const uint8_t cmd)
+{
+  // LPCD both for the calibration measurement and for arming
+  armed = (cmd == MFRC630_CMD_LPCD);
+  if (armed)
+    measure();
+}
+
+/** @brief Advance the simulated time by time spent awake
+ */
+static void spend(const uint32_t us)
+{
+  simUs += us;
+  awakeUs += us;
+}
+
+void write8(uint8_t reg, uint8_t value)
+{
+  spend(I2C_WRITE_US);
+  regs[reg] = value;
+
+  if (reg == MFRC630_REG_COMMAND)
+    command(value);
+}
+
+uint8_t read8(uint8_t reg)
+{
+  spend(I2C_READ_US);
+
+  switch (reg) {
+    case MFRC630_REG_LPCD_I_RESULT:
+      return resultI;
+    case MFRC630_REG_LPCD_Q_RESULT:
+      return resultQ;
+    case MFRC630_REG_T4_CONTROL:
+      // T4StartStopNow reads back as 0
+      return regs[reg] & ~0x40;
+    default:
+      return regs[reg];
+  }
+}
+
+void writeCommand(uint8_t cmd)
+{
+  write8(MFRC630_REG_COMMAND, cmd);
+}
+
+void rfidSoftReset(void)
+{
+  spend(SOFT_RESET_US);
+  memset(regs, 0, sizeof(regs));
+  regs[MFRC630_REG_TX_AMP] = 0x15;
+  regs[MFRC630_REG_DRV_CON] = 0x11;
+  regs[MFRC630_REG_TXL] = 0x06;
+  armed = false;
+}
+
+/** @brief Check the last result against the window registers
+ */
+static bool outsideWindow(void)
+{
+  uint8_t qMin = regs[MFRC630_REG_LPCD_QMIN] & LPCD_RESULT_MASK;
+  uint8_t qMax = regs[MFRC630_REG_LPCD_QMAX] & LPCD_RESULT_MASK;
+  uint8_t iMin = regs[MFRC630_REG_LPCD_IMIN] & LPCD_RESULT_MASK;
+  uint8_t iMax = ((regs[MFRC630_REG_LPCD_QMIN] >> 6) << 4)
+                 | ((regs[MFRC630_REG_LPCD_QMAX] >> 6) << 2)
+                 | (regs[MFRC630_REG_LPCD_IMIN] >> 6);
+
+  return (resultI < iMin) || (resultI > iMax) || (resultQ < qMin) || (resultQ > qMax);
+}
+
+/** @brief Power-down period from the T4 reload (2 kHz LFO)
+ */
+static uint32_t periodUs(void)
+{
+  uint16_t t4Reload = (regs[MFRC630_REG_T4_RELOAD_HI] << 8) | regs[MFRC630_REG_T4_RELOAD_LO];
+
+  return (uint32_t)(t4Reload + 1) * 1000 / DUTY_T4_TICKS_PER_MS;
+}
+
+/*---------------------------------------------------------------------------
+ * Application loop (handleTag and the duty event, as in main.c)
+ *-------------------------------------------------------------------------*/
+
+static uint32_t nextDutyMs = 0;
+
+static void rearm(void)
+{
+  lpcdRearm();
+  uint32_t next = dutyNextChangeMs();
+  nextDutyMs = (next > 0) ? halCommonGetInt32uMillisecondTick() + next : 0;
+}
+
+static int compareLatency(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+static void runScenario(const char *name, const uint32_t durationMs)
+{
+  detected = 0;
+  wakes = 0;
+  awakeUs = 0;
+  falseWakes = 0;
+  earlyWakes = 0;
+  thresholdReports = 0;
+  periodSum = 0;
+  periodCount = 0;
+  currentCard = 0;
+  traceIndex = 0;
+
+  scenarioStartUs = simUs;
+  lpcdRecalibrate();
+  rearm();
+
+  while (scenarioMs() < durationMs) {
+    if (!armed) {
+      printf("LPCD not armed at %u ms\n", scenarioMs());
+      rearm();
+    }
+
+    uint32_t period = periodUs();
+    periodSum += period;
+    periodCount++;
+    simUs += period;
+
+    // Duty cycle event due during this power-down period
+    if ((nextDutyMs != 0) && (halCommonGetInt32uMillisecondTick() >= nextDutyMs)) {
+      if (dutyChanged())
+        rearm();
+      else {
+        uint32_t next = dutyNextChangeMs();
+        nextDutyMs = (next > 0) ? halCommonGetInt32uMillisecondTick() + next : 0;
+      }
+    }
+
+    measure();
+    if (!outsideWindow())
+      continue;
+
+    wakes++;
+    lpcdCapture();
+
+    uint32_t t = scenarioMs();
+    sim_card_t *card = cardAt(t);
+    uint8_t i, q;
+
+    if ((card != NULL) && sampleAt(t, &i, &q)) {
+      if (!card->detected) {
+        card->detected = true;
+        latencies[detected++] = t - card->arrive;
+      }
+
+      // Probe answered, read, then presence tracking until the card has left
+      lpcdCardWake();
+      dutyActivity();
+      simUs = scenarioStartUs + (uint64_t)card->leave * 1000;
+    }
+    else {
+      if (card != NULL)
+        earlyWakes++;
+      else
+        falseWakes++;
+
+      spend(PROBE_US);
+      lpcdFalseWake();
+    }
+
+    rearm();
+  }
+
+  uint16_t cardsInRun = 0;
+  for (uint16_t n = 0; n < cardCount; n++)
+    if (cards[n].arrive < durationMs)
+      cardsInRun++;
+
+  uint32_t missed = cardsInRun - detected;
+  uint16_t p95 = (detected * 95) / 100;
+  double hours = (double)durationMs / SIM_MS_PER_HOUR;
+  double meanLatency = 0;
+
+  qsort(latencies, detected, sizeof(uint32_t), compareLatency);
+  for (uint16_t n = 0; n < detected; n++)
+    meanLatency += latencies[n];
+  if (detected > 0)
+    meanLatency /= detected;
+
+  printf("%-10s %-8s %6u %6u %6.2f%% %8.0f %8u %8u %9.2f %7u %7u %8.1f %7.2f %5u %4u\n",
+         SIM_VARIANT_NAME, name, cardsInRun, missed,
+         cardsInRun ? 100.0 * missed / cardsInRun : 0.0,
+         meanLatency,
+         detected ? latencies[p95] : 0,
+         detected ? latencies[detected - 1] : 0,
+         falseWakes / hours, earlyWakes, wakes,
+         periodCount ? (double)periodSum / periodCount / 1000 : 0.0,
+         awakeUs / 1e6 / hours,
+         lpcdThreshold(), thresholdReports);
+}
+
+int main(int argc, char *argv[])
+{
+  const char *tracePath = NULL;
+
+  for (int n = 1; n < argc; n++) {
+    if (strcmp(argv[n], "-v") == 0)
+      verbose = true;
+    else if ((strcmp(argv[n], "-s") == 0) && (n + 1 < argc))
+      seed = (uint32_t)strtoul(argv[++n], NULL, 0) | 1;
+    else
+      tracePath = argv[n];
+  }
+
+  printf("%-10s %-8s %6s %6s %7s %8s %8s %8s %9s %7s %7s %8s %7s %5s %4s\n",
+         "variant", "scenario", "cards", "missed", "miss", "lat-mean", "lat-p95", "lat-max",
+         "false/h", "early", "wakes", "period", "awake/h", "thr", "rep");
+
+  if (tracePath != NULL) {
+    if (!loadTrace(tracePath)) {
+      printf("cannot read trace %s\n", tracePath);
+      return 1;
+    }
+    runScenario("trace", trace[traceCount - 1].ms);
+    free(trace);
+    return 0;
+  }
+
+  for (uint8_t n = 0; n < sizeof(scenarios) / sizeof(scenarios[0]); n++) {
+    scenario = &scenarios[n];
+    generateCards(SIM_HOURS * SIM_MS_PER_HOUR);
+    runScenario(scenario->name, SIM_HOURS * SIM_MS_PER_HOUR);
+  }
+
+  return 0;
+}
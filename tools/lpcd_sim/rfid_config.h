@@ -0,0 +1,53 @@
+/*
+ * rfid_config.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ *
+ * Firmware configuration with the LPCD options of one algorithm variant
+ * (SIM_VARIANT) switched off. Found before config/rfid_config.h because
+ * tools/lpcd_sim comes first on the include path.
+ */
+
+#ifndef LPCD_SIM_RFID_CONFIG_H_
+#define LPCD_SIM_RFID_CONFIG_H_
+
+#include "../../config/rfid_config.h"
+
+#ifndef SIM_VARIANT
+#define SIM_VARIANT               3
+#endif
+
+/* 0: fixed window, fixed 10 ms period (the original firmware) */
+#if SIM_VARIANT == 0
+#define SIM_VARIANT_NAME          "fixed"
+#undef RFID_LPCD_DRIFT_MAX
+#define RFID_LPCD_DRIFT_MAX       63
+#endif
+
+/* 1: window follows the EWMA baseline */
+#if SIM_VARIANT == 1
+#define SIM_VARIANT_NAME          "ewma"
+#endif
+
+/* 2: EWMA baseline and false wake threshold tuning */
+#if SIM_VARIANT == 2
+#define SIM_VARIANT_NAME          "ewma+tune"
+#endif
+
+/* 3: as configured, incl. the activity-adaptive power-down period */
+#if SIM_VARIANT == 3
+#define SIM_VARIANT_NAME          "configured"
+#endif
+
+#if SIM_VARIANT < 2
+#undef RFID_LPCD_TUNE_PERIOD
+#define RFID_LPCD_TUNE_PERIOD     0
+#endif
+
+#if SIM_VARIANT < 3
+#undef RFID_LPCD_PERIOD_MAX
+#define RFID_LPCD_PERIOD_MAX      RFID_LPCD_PERIOD_MIN
+#endif
+
+#endif /* LPCD_SIM_RFID_CONFIG_H_ */
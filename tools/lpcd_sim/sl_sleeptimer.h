@@ -0,0 +1,19 @@
+/*
+ * sl_sleeptimer.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ *
+ * Host stand-in for the sleeptimer, with just what lpcd.c uses. Ticks
+ * come from the simulated time in lpcd_sim.c.
+ */
+
+#ifndef LPCD_SIM_SL_SLEEPTIMER_H_
+#define LPCD_SIM_SL_SLEEPTIMER_H_
+
+#include <stdint.h>
+
+uint32_t sl_sleeptimer_get_tick_count(void);
+uint32_t sl_sleeptimer_get_timer_frequency(void);
+
+#endif /* LPCD_SIM_SL_SLEEPTIMER_H_ */
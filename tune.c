@@ -0,0 +1,241 @@
+/*
+ * tune.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#include "tune.h"
+
+#include "em_wdog.h"
+
+#include "rfid_config.h"
+
+#define TUNE_CW_AMPLITUDE_MASK    0xC0        /**< TX_AMP set_cw_amplitude: 0 = TVDD-100 mV .. 3 = TVDD-1 V */
+#define TUNE_CW_AMPLITUDE_SHIFT   6
+#define TUNE_CW_AMPLITUDE_MAX     3
+#define TUNE_CW_MAX               0x08        /**< DRV_CON CwMax: drive the full TVDD */
+#define TUNE_MIN_LEVEL_MASK       0xF0        /**< RX_THRESHOLD MinLevel */
+#define TUNE_MIN_LEVEL_SHIFT      4
+#define TUNE_MIN_LEVEL_MAX        15
+#define TUNE_GAIN_MASK            0x03        /**< RX_ANA rcv_gain */
+#define TUNE_GAINS                4
+#define TUNE_FIELD_RESET_MS       5           /**< Field off time that resets the card to IDLE */
+
+static rfid_tag_t reference;
+
+/** @brief Transmitter settings of a level
+ *  @param level 0 (lowest field power) .. TUNE_LEVELS - 1 (board default, CwMax)
+ *  @param antenna Set to the board defaults with the level applied
+ */
+static void transmitter(const uint8_t level, rfid_antenna_t *antenna)
+{
+  *antenna = *rfidDefaultAntenna();
+
+  if (level == TUNE_LEVELS - 1) {
+    antenna->txAmp &= ~TUNE_CW_AMPLITUDE_MASK;
+    antenna->drvCon |= TUNE_CW_MAX;
+    return;
+  }
+
+  antenna->txAmp = (antenna->txAmp & ~TUNE_CW_AMPLITUDE_MASK)
+                   | ((TUNE_CW_AMPLITUDE_MAX - level) << TUNE_CW_AMPLITUDE_SHIFT);
+  antenna->drvCon &= ~TUNE_CW_MAX;
+}
+
+/** @brief Receiver MinLevel of RX_THRESHOLD
+ */
+static uint8_t minLevel(const rfid_antenna_t *antenna)
+{
+  return (antenna->rxThreshold & TUNE_MIN_LEVEL_MASK) >> TUNE_MIN_LEVEL_SHIFT;
+}
+
+static void setMinLevel(rfid_antenna_t *antenna, const uint8_t level)
+{
+  antenna->rxThreshold = (antenna->rxThreshold & ~TUNE_MIN_LEVEL_MASK) | (level << TUNE_MIN_LEVEL_SHIFT);
+}
+
+/** @brief Read a card from IDLE with the field just switched on
+ *  @param rfid_tag Tag; filled in on success
+ *  @return true if a card was read
+ */
+static bool readFresh(rfid_tag_t *rfid_tag)
+{
+  WDOGn_Feed(DEFAULT_WDOG);
+  rfidFieldOff();
+  halCommonDelayMilliseconds(TUNE_FIELD_RESET_MS);
+  rfidInit();
+
+  return readRfidTag(rfid_tag);
+}
+
+/** @brief Read the reference card a number of times
+ *  @return Number of reads that returned the reference UID
+ */
+static uint8_t countReads(const rfid_antenna_t *antenna, const uint8_t reads)
+{
+  rfid_tag_t rfid_tag;
+  uint8_t count = 0;
+
+  rfidSetAntenna(antenna);
+
+  for (uint8_t i = 0; i < reads; i++) {
+    if (readFresh(&rfid_tag)
+        && (rfid_tag.size == reference.size)
+        && (memcmp(rfid_tag.rfid, reference.rfid, reference.size) == 0))
+      count++;
+  }
+
+  return count;
+}
+
+/** @brief Raise the receiver MinLevel until the reference card no longer reads
+ *  @return Number of MinLevel steps above the setting that still read
+ */
+static uint8_t measureMargin(const rfid_antenna_t *antenna)
+{
+  rfid_antenna_t raised = *antenna;
+  uint8_t margin = 0;
+
+  for (uint8_t level = minLevel(antenna) + 1; level <= TUNE_MIN_LEVEL_MAX; level++) {
+    setMinLevel(&raised, level);
+    if (countReads(&raised, RFID_TUNE_MARGIN_READS) < RFID_TUNE_MARGIN_READS)
+      break;
+    margin++;
+  }
+
+  return margin;
+}
+
+/** @brief Score a setting
+ *  @param margin Set to the margin if all reads succeeded, else 0
+ *  @return true if all RFID_TUNE_READS reads returned the reference UID
+ */
+static bool score(const rfid_antenna_t *antenna, uint8_t *margin)
+{
+  uint8_t reads = countReads(antenna, RFID_TUNE_READS);
+
+  *margin = (reads == RFID_TUNE_READS) ? measureMargin(antenna) : 0;
+
+  emberAfCorePrintln("tune: TX_AMP 0x%x DRV_CON 0x%x RX_THRESHOLD 0x%x RX_ANA 0x%x: %d/%d reads, margin %d",
+                     antenna->txAmp, antenna->drvCon, antenna->rxThreshold, antenna->rxAna,
+                     reads, RFID_TUNE_READS, *margin);
+
+  return reads == RFID_TUNE_READS;
+}
+
+/** @brief Load the stored profile into the reader settings
+ *  @return true if a profile was stored
+ */
+bool tuneRestore(void)
+{
+  tokTypeRfidTuning token;
+  rfid_antenna_t antenna;
+
+  halCommonGetToken(&token, TOKEN_RFID_TUNING);
+
+  if (token.magic != RFID_TUNING_MAGIC)
+    return false;
+
+  antenna.txAmp = token.txAmp;
+  antenna.drvCon = token.drvCon;
+  antenna.rxThreshold = token.rxThreshold;
+  antenna.rxAna = token.rxAna;
+  rfidSetAntenna(&antenna);
+
+  emberAfCorePrintln("tune: level %d, margin %d restored", token.level, token.margin);
+  return true;
+}
+
+/** @brief Find the lowest field power that reads the reference card reliably
+ *  @return true if a profile was found and stored
+ *  @note The reference card must be in the field. Blocks for several
+ *        seconds; LPCD must be re-armed afterwards.
+ */
+bool tuneRun(void)
+{
+  rfid_antenna_t previous = *rfidAntenna();
+  rfid_antenna_t candidate;
+  rfid_antenna_t best;
+  tokTypeRfidTuning token;
+  uint8_t margin;
+  uint8_t bestMargin = 0;
+  int8_t bestLevel = -1;
+
+  // Reference card at the board defaults
+  rfidSetAntenna(NULL);
+  if (!readFresh(&reference)) {
+    emberAfCorePrintln("tune: no reference card");
+    rfidSetAntenna(&previous);
+    rfidFieldOff();
+    return false;
+  }
+
+  // Transmitter: first level with enough margin; else the passing level with the most
+  for (uint8_t level = 0; level < TUNE_LEVELS; level++) {
+    transmitter(level, &candidate);
+    if (!score(&candidate, &margin))
+      continue;
+
+    if ((bestLevel < 0) || (margin > bestMargin)) {
+      best = candidate;
+      bestMargin = margin;
+      bestLevel = level;
+    }
+
+    if (margin >= RFID_TUNE_MIN_MARGIN)
+      break;
+  }
+
+  if (bestLevel < 0) {
+    emberAfCorePrintln("tune: no level reads reliably; settings kept");
+    rfidSetAntenna(&previous);
+    rfidFieldOff();
+    return false;
+  }
+
+  // Receiver: lowest gain below the default with enough margin at that level
+  for (uint8_t gain = 0; gain < TUNE_GAINS; gain++) {
+    candidate = best;
+    candidate.rxAna = (candidate.rxAna & ~TUNE_GAIN_MASK) | gain;
+    if (candidate.rxAna == best.rxAna)
+      break;
+
+    if (score(&candidate, &margin) && (margin >= RFID_TUNE_MIN_MARGIN)) {
+      best = candidate;
+      bestMargin = margin;
+      break;
+    }
+  }
+
+  // Threshold halfway up the margin, rejecting noise while keeping headroom
+  setMinLevel(&best, minLevel(&best) + bestMargin / 2);
+  bestMargin -= bestMargin / 2;
+
+  token.magic = RFID_TUNING_MAGIC;
+  token.txAmp = best.txAmp;
+  token.drvCon = best.drvCon;
+  token.rxThreshold = best.rxThreshold;
+  token.rxAna = best.rxAna;
+  token.level = (uint8_t)bestLevel;
+  token.margin = bestMargin;
+  halCommonSetToken(TOKEN_RFID_TUNING, &token);
+
+  rfidSetAntenna(&best);
+  rfidFieldOff();
+
+  emberAfCorePrintln("tune: level %d/%d, TX_AMP 0x%x DRV_CON 0x%x RX_THRESHOLD 0x%x RX_ANA 0x%x, margin %d stored",
+                     bestLevel, TUNE_LEVELS - 1, best.txAmp, best.drvCon, best.rxThreshold, best.rxAna, bestMargin);
+  return true;
+}
+
+/** @brief Drop the stored profile and go back to the board defaults
+ */
+void tuneClear(void)
+{
+  tokTypeRfidTuning token;
+
+  memset(&token, 0, sizeof(token));
+  halCommonSetToken(TOKEN_RFID_TUNING, &token);
+  rfidSetAntenna(NULL);
+}
@@ -0,0 +1,22 @@
+/*
+ * tune.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: agent
+ */
+
+#ifndef TUNE_H_
+#define TUNE_H_
+
+#include "app/framework/include/af.h"
+
+#include "rfid.h"
+
+/*! Transmitter levels swept, lowest field power first */
+#define TUNE_LEVELS               5
+
+bool tuneRestore(void);
+bool tuneRun(void);
+void tuneClear(void);
+
+#endif /* TUNE_H_ */